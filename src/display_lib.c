@@ -1,12 +1,51 @@
 /* src/display_lib.c */
+#include <string.h>
+#include <stdlib.h>
 #include <zephyr/kernel.h>
 #include <zephyr/drivers/display.h>
 #include <zephyr/display/cfb.h>
 #include <zephyr/logging/log.h>
+#include <zephyr/sys/iterable_sections.h>
 #include "display_lib.h"
+#include "epd_graphics.h"
 
 LOG_MODULE_REGISTER(display_lib, LOG_LEVEL_INF);
 
+#if !defined(CONFIG_EPD_BANDED)
+BUILD_ASSERT(IS_ENABLED(CONFIG_CHARACTER_FRAMEBUFFER),
+	     "frames are drawn in the CFB framebuffer unless CONFIG_EPD_BANDED is set");
+
+/* cfb_framebuffer_init() takes the whole frame from the heap */
+BUILD_ASSERT(CONFIG_HEAP_MEM_POOL_SIZE >= EPD_LOGICAL_WIDTH * EPD_LOGICAL_HEIGHT / 8,
+	     "CONFIG_HEAP_MEM_POOL_SIZE is too small for the CFB framebuffer");
+#endif
+
+/*
+ * 1-bit drawing target: MONO10, vertical tiled, MSB is the top pixel of
+ * each byte. Holds columns [x0, x0 + width), width bytes per page.
+ */
+struct surface {
+	uint8_t *buf;
+	int x0;
+	int width;
+	int height;
+};
+
+/* The CFB framebuffer, or the current band inside display_render_bands() */
+static struct surface fb;
+
+/* Logical display width; fb only covers part of it while rendering bands */
+static int screen_width;
+
+/* Index of the active CFB font, mirrored for display_draw_text() */
+static uint8_t font_idx;
+
+/* Font pack font overriding the CFB font in display_draw_text(), if set */
+static const struct display_font *pack_font;
+
+/* Set by display_invert(); frames are sent with black and white swapped */
+static bool inverted;
+
 /**
  * @brief Initialize the display library.
  *
@@ -16,6 +55,7 @@ LOG_MODULE_REGISTER(display_lib, LOG_LEVEL_INF);
  * - Sets the pixel format to monochrome.
  * - Initializes the Character Framebuffer (CFB) subsystem.
  * - Clears the framebuffer.
+ * - Looks up the CFB buffer so primitives can draw into it directly.
  * - Sets the default font.
  *
  * @usage
@@ -54,6 +94,15 @@ int display_lib_init(const struct device *dev)
 		return -EIO;
 	}
 
+#if defined(CONFIG_EPD_BANDED)
+	/* No frame buffer: everything is drawn by display_render_bands() */
+	struct display_capabilities caps;
+
+	display_get_capabilities(dev, &caps);
+	fb = (struct surface){NULL, 0, caps.x_resolution, caps.y_resolution};
+	screen_width = fb.width;
+	return 0;
+#else
 	if (cfb_framebuffer_init(dev)) {
 		LOG_ERR("Framebuffer initialization failed!");
 		return -EIO;
@@ -61,28 +110,84 @@ int display_lib_init(const struct device *dev)
 
 	cfb_framebuffer_clear(dev, false);
 
+	/*
+	 * CFB does not expose its buffer, but passes it to the driver on
+	 * finalize. Do that once while blanked so the panel is left alone.
+	 */
+	display_blanking_on(dev);
+	cfb_framebuffer_finalize(dev);
+	display_blanking_off(dev);
+
+	fb.buf = epd_graphics_get_framebuffer(dev);
+	fb.x0 = 0;
+	fb.width = cfb_get_display_parameter(dev, CFB_DISPLAY_WIDTH);
+	fb.height = cfb_get_display_parameter(dev, CFB_DISPLAY_HEIGH);
+	screen_width = fb.width;
+	if (fb.buf == NULL) {
+		LOG_ERR("Framebuffer not available");
+		return -EIO;
+	}
+
 	/* Use default font (index 0) */
 	if (cfb_framebuffer_set_font(dev, 0)) {
 		LOG_WRN("Could not set font, CFB might not have fonts enabled in config");
 	}
 
 	return 0;
+#endif
 }
 
+#if !defined(CONFIG_EPD_BANDED)
 void display_print(const struct device *dev, const char *str, uint16_t x, uint16_t y)
 {
 	cfb_print(dev, str, x, y);
 }
+#endif
+
+int display_get_font_size(const struct device *dev, uint8_t idx, uint8_t *width,
+			  uint8_t *height)
+{
+	ARG_UNUSED(dev);
+
+#if defined(CONFIG_CHARACTER_FRAMEBUFFER)
+	const struct cfb_font *font;
+	int num_fonts;
+
+	/* Straight from the font section: CFB only counts fonts once initialized */
+	STRUCT_SECTION_COUNT(cfb_font, &num_fonts);
+	if (idx < num_fonts) {
+		STRUCT_SECTION_GET(cfb_font, idx, &font);
+		*width = font->width;
+		*height = font->height;
+		return 0;
+	}
+#endif
+	return -EINVAL;
+}
 
-int display_set_font(const struct device *dev, uint8_t font_idx)
+int display_set_font(const struct device *dev, uint8_t idx)
 {
-	return cfb_framebuffer_set_font(dev, font_idx);
+#if defined(CONFIG_EPD_BANDED)
+	uint8_t width;
+	uint8_t height;
+	int err = display_get_font_size(dev, idx, &width, &height);
+#else
+	int err = cfb_framebuffer_set_font(dev, idx);
+#endif
+
+	if (err == 0) {
+		font_idx = idx;
+		pack_font = NULL;
+	}
+	return err;
 }
 
+#if !defined(CONFIG_EPD_BANDED)
 void display_draw_rect(const struct device *dev, uint16_t x, uint16_t y, uint16_t w, uint16_t h)
 {
 	struct cfb_position start = {x, y};
 	struct cfb_position end = {x + w, y + h};
+
 	cfb_draw_rect(dev, &start, &end);
 }
 
@@ -91,3 +196,1142 @@ void display_flush(const struct device *dev)
 	LOG_INF("Finalizing...");
 	cfb_framebuffer_finalize(dev);
 }
+#endif
+
+/* --- Span primitives --- */
+
+static inline uint8_t pen_apply(uint8_t dst, uint8_t mask, enum display_pen pen)
+{
+	switch (pen) {
+	case DISPLAY_PEN_SET:
+		return dst | mask;
+	case DISPLAY_PEN_CLEAR:
+		return dst & ~mask;
+	default:
+		return dst ^ mask;
+	}
+}
+
+static inline uint32_t pen_apply32(uint32_t dst, uint32_t mask, enum display_pen pen)
+{
+	switch (pen) {
+	case DISPLAY_PEN_SET:
+		return dst | mask;
+	case DISPLAY_PEN_CLEAR:
+		return dst & ~mask;
+	default:
+		return dst ^ mask;
+	}
+}
+
+static inline uint32_t load32(const uint8_t *p)
+{
+	uint32_t v;
+
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static inline void store32(uint8_t *p, uint32_t v)
+{
+	memcpy(p, &v, sizeof(v));
+}
+
+/* Apply the same mask byte to n consecutive bytes of one page row */
+static void span_apply(uint8_t *p, size_t n, uint8_t mask, enum display_pen pen)
+{
+	if (mask == 0xFF && pen != DISPLAY_PEN_INVERT) {
+		memset(p, pen == DISPLAY_PEN_SET ? 0xFF : 0x00, n);
+		return;
+	}
+
+	uint32_t mask32 = mask * 0x01010101U;
+
+	for (; n >= 4; n -= 4, p += 4) {
+		store32(p, pen_apply32(load32(p), mask32, pen));
+	}
+
+	while (n-- > 0) {
+		*p = pen_apply(*p, mask, pen);
+		p++;
+	}
+}
+
+/* Byte holding column x of a page */
+static inline uint8_t *fb_at(int page, int x)
+{
+	return &fb.buf[page * fb.width + x - fb.x0];
+}
+
+/* Clip an inclusive rectangle to the framebuffer, false if nothing is left */
+static bool clip_rect(int *x0, int *y0, int *x1, int *y1)
+{
+	if (*x0 < fb.x0) {
+		*x0 = fb.x0;
+	}
+	if (*y0 < 0) {
+		*y0 = 0;
+	}
+	if (*x1 >= fb.x0 + fb.width) {
+		*x1 = fb.x0 + fb.width - 1;
+	}
+	if (*y1 >= fb.height) {
+		*y1 = fb.height - 1;
+	}
+	return *x0 <= *x1 && *y0 <= *y1;
+}
+
+/* Bounding boxes are clipped to the display, not to the current band */
+static void set_bbox(struct display_rect *bbox, int x0, int y0, int x1, int y1)
+{
+	if (bbox == NULL) {
+		return;
+	}
+	x0 = MAX(x0, 0);
+	y0 = MAX(y0, 0);
+	x1 = MIN(x1, screen_width - 1);
+	y1 = MIN(y1, fb.height - 1);
+	if (x0 > x1 || y0 > y1) {
+		*bbox = (struct display_rect){0};
+		return;
+	}
+	bbox->x = x0;
+	bbox->y = y0;
+	bbox->w = x1 - x0 + 1;
+	bbox->h = y1 - y0 + 1;
+}
+
+/* Fill the inclusive rectangle page by page: masked edge pages, full interior pages */
+static void fill_span(int x0, int y0, int x1, int y1, enum display_pen pen)
+{
+	if (fb.buf == NULL || !clip_rect(&x0, &y0, &x1, &y1)) {
+		return;
+	}
+
+	int first = y0 / 8;
+	int last = y1 / 8;
+	size_t n = x1 - x0 + 1;
+
+	for (int page = first; page <= last; page++) {
+		uint8_t mask = 0xFF;
+
+		if (page == first) {
+			mask &= 0xFF >> (y0 % 8);
+		}
+		if (page == last) {
+			mask &= (uint8_t)(0xFF << (7 - (y1 % 8)));
+		}
+		span_apply(fb_at(page, x0), n, mask, pen);
+	}
+}
+
+void display_fill_rect(const struct device *dev, uint16_t x, uint16_t y, uint16_t w, uint16_t h,
+		       enum display_pen pen, struct display_rect *bbox)
+{
+	ARG_UNUSED(dev);
+
+	if (w == 0 || h == 0) {
+		set_bbox(bbox, 0, 0, -1, -1);
+		return;
+	}
+	fill_span(x, y, x + w - 1, y + h - 1, pen);
+	set_bbox(bbox, x, y, x + w - 1, y + h - 1);
+}
+
+/*
+ * Bresenham along the major axis, emitting each run of pixels that share
+ * a minor coordinate as one span. Pure horizontal or vertical lines are a
+ * single span.
+ */
+static void draw_line_runs(int x0, int y0, int x1, int y1, enum display_pen pen)
+{
+	int dx = abs(x1 - x0);
+	int dy = abs(y1 - y0);
+	int sx = x0 < x1 ? 1 : -1;
+	int sy = y0 < y1 ? 1 : -1;
+
+	if (dy == 0) {
+		fill_span(MIN(x0, x1), y0, MAX(x0, x1), y0, pen);
+		return;
+	}
+	if (dx == 0) {
+		fill_span(x0, MIN(y0, y1), x0, MAX(y0, y1), pen);
+		return;
+	}
+
+	if (dx >= dy) {
+		int d = 2 * dy - dx;
+		int run = x0;
+
+		for (int x = x0;; x += sx) {
+			if (x == x1) {
+				fill_span(MIN(run, x), y0, MAX(run, x), y0, pen);
+				break;
+			}
+			if (d > 0) {
+				fill_span(MIN(run, x), y0, MAX(run, x), y0, pen);
+				y0 += sy;
+				d -= 2 * dx;
+				run = x + sx;
+			}
+			d += 2 * dy;
+		}
+	} else {
+		int d = 2 * dx - dy;
+		int run = y0;
+
+		for (int y = y0;; y += sy) {
+			if (y == y1) {
+				fill_span(x0, MIN(run, y), x0, MAX(run, y), pen);
+				break;
+			}
+			if (d > 0) {
+				fill_span(x0, MIN(run, y), x0, MAX(run, y), pen);
+				x0 += sx;
+				d -= 2 * dy;
+				run = y + sy;
+			}
+			d += 2 * dx;
+		}
+	}
+}
+
+void display_draw_line(const struct device *dev, uint16_t x0, uint16_t y0, uint16_t x1,
+		       uint16_t y1, enum display_pen pen, struct display_rect *bbox)
+{
+	ARG_UNUSED(dev);
+
+	draw_line_runs(x0, y0, x1, y1, pen);
+	set_bbox(bbox, MIN(x0, x1), MIN(y0, y1), MAX(x0, x1), MAX(y0, y1));
+}
+
+/*
+ * Half-width of the circle at vertical offset dy, walked incrementally
+ * from the previous row. The r * r + r threshold matches the midpoint
+ * algorithm's rounding.
+ */
+static inline int circle_half_width(int hw, int dy, int r)
+{
+	while (hw > 0 && hw * hw + dy * dy > r * r + r) {
+		hw--;
+	}
+	return hw;
+}
+
+void display_draw_circle(const struct device *dev, uint16_t cx, uint16_t cy, uint16_t r,
+			 enum display_pen pen, struct display_rect *bbox)
+{
+	ARG_UNUSED(dev);
+
+	int hw = r;
+
+	/*
+	 * Each row's outline runs from just outside the next row's half-width
+	 * out to this row's, so neighbouring rows join without gaps or overlap.
+	 */
+	for (int dy = 0; dy <= r; dy++) {
+		hw = circle_half_width(hw, dy, r);
+		int inner = dy < r ? circle_half_width(hw, dy + 1, r) + 1 : 0;
+
+		inner = MIN(inner, hw);
+		for (int s = 1; s >= -1; s -= 2) {
+			int y = cy + s * dy;
+
+			if (inner == 0) {
+				fill_span(cx - hw, y, cx + hw, y, pen);
+			} else {
+				fill_span(cx - hw, y, cx - inner, y, pen);
+				fill_span(cx + inner, y, cx + hw, y, pen);
+			}
+			if (dy == 0) {
+				break;
+			}
+		}
+	}
+	set_bbox(bbox, cx - r, cy - r, cx + r, cy + r);
+}
+
+void display_fill_circle(const struct device *dev, uint16_t cx, uint16_t cy, uint16_t r,
+			 enum display_pen pen, struct display_rect *bbox)
+{
+	ARG_UNUSED(dev);
+
+	int hw = r;
+
+	for (int dy = 0; dy <= r; dy++) {
+		hw = circle_half_width(hw, dy, r);
+		fill_span(cx - hw, cy + dy, cx + hw, cy + dy, pen);
+		if (dy != 0) {
+			fill_span(cx - hw, cy - dy, cx + hw, cy - dy, pen);
+		}
+	}
+	set_bbox(bbox, cx - r, cy - r, cx + r, cy + r);
+}
+
+static inline uint32_t rop_apply(uint32_t dst, uint32_t src, uint32_t mask, enum display_rop rop)
+{
+	switch (rop) {
+	case DISPLAY_ROP_COPY:
+		return (dst & ~mask) | (src & mask);
+	case DISPLAY_ROP_AND:
+		return dst & (src | ~mask);
+	case DISPLAY_ROP_OR:
+		return dst | (src & mask);
+	default:
+		return dst ^ (src & mask);
+	}
+}
+
+/*
+ * Merge one source page row into the framebuffer, shifted down by 0..7
+ * rows. Four columns are handled per 32-bit word: every byte lane is
+ * shifted independently, with lane masks dropping bits that cross into
+ * the neighbouring column. The top part lands in hi, the rest in lo.
+ */
+static void merge_page_row(uint8_t *hi, uint8_t *lo, const uint8_t *src, int n, int shift,
+			   uint8_t hi_mask, uint8_t lo_mask, enum display_rop rop)
+{
+	uint32_t hi_keep = (0xFFU >> shift) * 0x01010101U;
+	uint32_t lo_keep = (uint8_t)(0xFFU << (8 - shift)) * 0x01010101U;
+	uint32_t hi_mask32 = hi_mask * 0x01010101U;
+	uint32_t lo_mask32 = lo_mask * 0x01010101U;
+	int i = 0;
+
+	for (; i + 4 <= n; i += 4) {
+		uint32_t w = load32(&src[i]);
+
+		store32(&hi[i], rop_apply(load32(&hi[i]), (w >> shift) & hi_keep, hi_mask32, rop));
+		if (lo) {
+			store32(&lo[i], rop_apply(load32(&lo[i]), (w << (8 - shift)) & lo_keep,
+						  lo_mask32, rop));
+		}
+	}
+
+	for (; i < n; i++) {
+		hi[i] = rop_apply(hi[i], src[i] >> shift, hi_mask, rop);
+		if (lo) {
+			lo[i] = rop_apply(lo[i], (uint8_t)(src[i] << (8 - shift)), lo_mask, rop);
+		}
+	}
+}
+
+void display_blit(const struct device *dev, const struct display_bitmap *bmp, uint16_t x,
+		  uint16_t y, enum display_rop rop, struct display_rect *bbox)
+{
+	ARG_UNUSED(dev);
+
+	int x0 = x;
+	int y0 = y;
+	int x1 = x + bmp->width - 1;
+	int y1 = y + bmp->height - 1;
+
+	set_bbox(bbox, x0, y0, x1, y1);
+	if (fb.buf == NULL || bmp->width == 0 || bmp->height == 0 ||
+	    !clip_rect(&x0, &y0, &x1, &y1)) {
+		return;
+	}
+
+	int src_pages = (bmp->height + 7) / 8;
+	int fb_pages = fb.height / 8;
+	int shift = y % 8;
+
+	/*
+	 * Each source page straddles at most two framebuffer pages. The
+	 * masks carry clipping against the bitmap and framebuffer bottom.
+	 */
+	for (int sp = 0; sp < src_pages; sp++) {
+		int top = y + sp * 8;
+		int rows = MIN(8, y1 - top + 1);
+
+		if (rows <= 0) {
+			break;
+		}
+
+		uint8_t valid = (uint8_t)(0xFF << (8 - rows));
+		uint8_t hi_mask = valid >> shift;
+		uint8_t lo_mask = shift ? (uint8_t)(valid << (8 - shift)) : 0;
+		int dp = top / 8;
+		uint8_t *hi = fb_at(dp, x0);
+		uint8_t *lo = (lo_mask && dp + 1 < fb_pages) ? hi + fb.width : NULL;
+
+		merge_page_row(hi, lo, &bmp->data[sp * bmp->width + (x0 - x)], x1 - x0 + 1, shift,
+			       hi_mask, lo_mask, rop);
+	}
+}
+
+/* --- Scrolling --- */
+
+/* Rows [r0, r1] that fall into the given page, as a bit mask */
+static inline uint8_t page_rows(int page, int r0, int r1)
+{
+	r0 = MAX(r0, page * 8);
+	r1 = MIN(r1, page * 8 + 7);
+	if (r0 > r1) {
+		return 0;
+	}
+	return (0xFF >> (r0 % 8)) & (uint8_t)(0xFF << (7 - (r1 % 8)));
+}
+
+#if !defined(CONFIG_EPD_BANDED)
+
+static inline uint32_t lanes_shl(uint32_t w, int s)
+{
+	return s >= 8 ? 0 : (w << s) & ((uint8_t)(0xFF << s) * 0x01010101U);
+}
+
+static inline uint32_t lanes_shr(uint32_t w, int s)
+{
+	return s >= 8 ? 0 : (w >> s) & ((0xFFU >> s) * 0x01010101U);
+}
+
+/*
+ * Move the rows of columns [x0, x1] vertically by dy inside rows [y0, y1].
+ * Each destination page is assembled from the two source pages it
+ * overlaps (a shifted up by sa, b shifted down by sb), four columns per
+ * 32-bit word. Pages are visited so every source is read before it is
+ * overwritten.
+ */
+static void scroll_rows(int x0, int x1, int y0, int y1, int dy)
+{
+	int n = abs(dy);
+	int q = n / 8;
+	int s = n % 8;
+	int pages = fb.height / 8;
+	int first = y0 / 8;
+	int last = y1 / 8;
+	int len = x1 - x0 + 1;
+
+	for (int i = 0; i <= last - first; i++) {
+		int page = dy < 0 ? first + i : last - i;
+		int pa = dy < 0 ? page + q : page - q - 1;
+		int sa = dy < 0 ? s : 8 - s;
+		int sb = dy < 0 ? 8 - s : s;
+		uint8_t region = page_rows(page, y0, y1);
+		uint8_t moved = page_rows(page, MAX(y0, y0 + dy), MIN(y1, y1 + dy));
+		const uint8_t *a = (pa >= 0 && pa < pages) ? &fb.buf[pa * fb.width + x0] : NULL;
+		const uint8_t *b = (pa + 1 >= 0 && pa + 1 < pages) ? &fb.buf[(pa + 1) * fb.width + x0]
+								   : NULL;
+		uint8_t *d = &fb.buf[page * fb.width + x0];
+		uint32_t region32 = region * 0x01010101U;
+		uint32_t moved32 = moved * 0x01010101U;
+		int c = 0;
+
+		for (; c + 4 <= len; c += 4) {
+			uint32_t v = (a ? lanes_shl(load32(&a[c]), sa) : 0) |
+				     (b ? lanes_shr(load32(&b[c]), sb) : 0);
+
+			store32(&d[c], (load32(&d[c]) & ~region32) | (v & moved32));
+		}
+		for (; c < len; c++) {
+			uint8_t v = (a ? lanes_shl(a[c], sa) : 0) | (b ? lanes_shr(b[c], sb) : 0);
+
+			d[c] = (d[c] & ~region) | (v & moved);
+		}
+	}
+}
+
+/* Move columns [x0, x1] horizontally by dx inside rows [y0, y1] */
+static void scroll_columns(int x0, int x1, int y0, int y1, int dx)
+{
+	int len = x1 - x0 + 1 - abs(dx);
+	int from = dx < 0 ? x0 - dx : x0;
+	int to = dx < 0 ? x0 : x0 + dx;
+	int gap = dx < 0 ? MAX(x0, x1 + dx + 1) : x0;
+
+	for (int page = y0 / 8; page <= y1 / 8; page++) {
+		uint8_t mask = page_rows(page, y0, y1);
+		uint8_t *row = &fb.buf[page * fb.width];
+
+		if (mask == 0xFF) {
+			if (len > 0) {
+				memmove(&row[to], &row[from], len);
+			}
+			memset(&row[gap], 0, MIN(abs(dx), x1 - x0 + 1));
+			continue;
+		}
+
+		/* Partial page: keep rows outside the region, walk away from the overlap */
+		for (int i = 0; i < len; i++) {
+			int k = dx < 0 ? i : len - 1 - i;
+
+			row[to + k] = (row[to + k] & ~mask) | (row[from + k] & mask);
+		}
+		span_apply(&row[gap], MIN(abs(dx), x1 - x0 + 1), mask, DISPLAY_PEN_CLEAR);
+	}
+}
+
+int display_scroll(const struct device *dev, const struct display_rect *region, int dx, int dy,
+		   struct display_rect *exposed)
+{
+	ARG_UNUSED(dev);
+
+	int x0 = region->x;
+	int y0 = region->y;
+	int x1 = region->x + region->w - 1;
+	int y1 = region->y + region->h - 1;
+
+	if (dx != 0 && dy != 0) {
+		return -EINVAL;
+	}
+	if (fb.buf == NULL || region->w == 0 || region->h == 0 ||
+	    !clip_rect(&x0, &y0, &x1, &y1)) {
+		set_bbox(exposed, 0, 0, -1, -1);
+		return 0;
+	}
+
+	if (dy != 0) {
+		scroll_rows(x0, x1, y0, y1, dy);
+		set_bbox(exposed, x0, dy < 0 ? MAX(y0, y1 + dy + 1) : y0, x1,
+			 dy < 0 ? y1 : MIN(y1, y0 + dy - 1));
+	} else if (dx != 0) {
+		scroll_columns(x0, x1, y0, y1, dx);
+		set_bbox(exposed, dx < 0 ? MAX(x0, x1 + dx + 1) : x0, y0,
+			 dx < 0 ? x1 : MIN(x1, x0 + dx - 1), y1);
+	} else {
+		set_bbox(exposed, 0, 0, -1, -1);
+	}
+
+	return 0;
+}
+
+#endif /* !CONFIG_EPD_BANDED */
+
+int display_invert(const struct device *dev)
+{
+#if !defined(CONFIG_EPD_BANDED)
+	int err = cfb_framebuffer_invert(dev);
+
+	if (err) {
+		return err;
+	}
+#endif
+	inverted = !inverted;
+	return 0;
+}
+
+#if !defined(CONFIG_EPD_BANDED)
+
+/* Toggle columns [x0, x1] of pages [first, last] of the framebuffer */
+static void invert_pages(int first, int last, int x0, int x1)
+{
+	for (int page = first; page <= last; page++) {
+		span_apply(fb_at(page, x0), x1 - x0 + 1, 0xFF, DISPLAY_PEN_INVERT);
+	}
+}
+
+int display_flush_region(const struct device *dev, const struct display_rect *area)
+{
+	int x0 = area->x;
+	int y0 = area->y;
+	int x1 = area->x + area->w - 1;
+	int y1 = area->y + area->h - 1;
+
+	if (fb.buf == NULL) {
+		return -EIO;
+	}
+	if (area->w == 0 || area->h == 0 || !clip_rect(&x0, &y0, &x1, &y1)) {
+		return 0;
+	}
+
+	/* The driver takes whole MONO10 pages */
+	int first = y0 / 8;
+	int last = y1 / 8;
+	struct display_buffer_descriptor desc = {
+		.width = x1 - x0 + 1,
+		.height = (last - first + 1) * 8,
+		.pitch = fb.width,
+		.buf_size = (last - first) * fb.width + (x1 - x0 + 1),
+	};
+
+	int err;
+
+	/*
+	 * cfb_framebuffer_finalize() inverts the buffer around its write when
+	 * MONO10 and the inverted flag disagree; MONO10 is always set here, so
+	 * that happens exactly when display_invert() was called.
+	 */
+	if (inverted) {
+		invert_pages(first, last, x0, x1);
+	}
+	err = display_write(dev, x0, first * 8, &desc, &fb.buf[first * fb.width + x0]);
+	if (inverted) {
+		invert_pages(first, last, x0, x1);
+	}
+
+	return err;
+}
+
+#endif /* !CONFIG_EPD_BANDED */
+
+/* --- Text --- */
+
+static inline uint8_t reverse_byte(uint8_t b)
+{
+	b = (b & 0xF0) >> 4 | (b & 0x0F) << 4;
+	b = (b & 0xCC) >> 2 | (b & 0x33) << 2;
+	b = (b & 0xAA) >> 1 | (b & 0x55) << 1;
+	return b;
+}
+
+/* Active font resolved for drawing; exactly one of cfb and pack is set */
+struct text_font {
+	const struct cfb_font *cfb;
+	const struct display_font *pack;
+	int width;
+	int height;
+	bool reverse;
+};
+
+/*
+ * Draw one VPACKED glyph column by column. The column's pages are
+ * contiguous in the font, so up to three of them are packed MSB-first into
+ * a 32-bit word, shifted down once and split over four surface pages.
+ */
+static void draw_glyph(const struct surface *s, const struct text_font *tf, const uint8_t *glyph,
+		       int x, int y, int x0, int x1, enum display_rop rop)
+{
+	int pages = tf->height / 8;
+	int s_pages = s->height / 8;
+	int shift = y % 8;
+
+	for (int col = x0; col <= x1; col++) {
+		const uint8_t *src = &glyph[(col - x) * pages];
+
+		for (int sp = 0; sp < pages; sp += 3) {
+			int n = MIN(3, pages - sp);
+			uint32_t word = 0;
+			uint32_t mask = (0xFFFFFFFFU << (32 - 8 * n)) >> shift;
+
+			for (int k = 0; k < n; k++) {
+				uint8_t b = tf->reverse ? reverse_byte(src[sp + k]) : src[sp + k];
+
+				word |= (uint32_t)b << (24 - 8 * k);
+			}
+			word >>= shift;
+
+			for (int k = 0; k <= n; k++) {
+				int dp = y / 8 + sp + k;
+				uint8_t m = mask >> (24 - 8 * k);
+
+				if (m == 0 || dp >= s_pages) {
+					continue;
+				}
+
+				uint8_t *d = &s->buf[dp * s->width + col - s->x0];
+
+				*d = rop_apply(*d, (uint8_t)(word >> (24 - 8 * k)), m, rop);
+			}
+		}
+	}
+}
+
+/* Decode one UTF-8 character; stray bytes are passed through as-is */
+static uint16_t utf8_next(const char **str)
+{
+	const uint8_t *s = (const uint8_t *)*str;
+	uint16_t c = s[0];
+	int extra = 0;
+
+	if ((c & 0xE0) == 0xC0) {
+		c &= 0x1F;
+		extra = 1;
+	} else if ((c & 0xF0) == 0xE0) {
+		c &= 0x0F;
+		extra = 2;
+	}
+
+	for (int i = 1; i <= extra; i++) {
+		if ((s[i] & 0xC0) != 0x80) {
+			*str += 1;
+			return s[0];
+		}
+		c = (c << 6) | (s[i] & 0x3F);
+	}
+
+	*str += 1 + extra;
+	return c;
+}
+
+static const uint8_t *pack_find_glyph(const struct display_font *font, uint16_t c)
+{
+	int lo = 0;
+	int hi = font->num_glyphs - 1;
+
+	while (lo <= hi) {
+		int mid = (lo + hi) / 2;
+
+		if (font->chars[mid] == c) {
+			return &font->bitmaps[font->offsets[mid]];
+		}
+		if (font->chars[mid] < c) {
+			lo = mid + 1;
+		} else {
+			hi = mid - 1;
+		}
+	}
+	return NULL;
+}
+
+static const uint8_t *cfb_find_glyph(const struct cfb_font *font, uint16_t c)
+{
+	if (c < font->first_char || c > font->last_char) {
+		return NULL;
+	}
+	return (const uint8_t *)font->data + (c - font->first_char) * font->width * (font->height / 8);
+}
+
+int display_set_pack_font(const struct device *dev, const struct display_font *font)
+{
+	ARG_UNUSED(dev);
+
+	if (font != NULL && (font->height % 8) != 0) {
+		return -EINVAL;
+	}
+	pack_font = font;
+	return 0;
+}
+
+static int text_font_get(const struct device *dev, struct text_font *tf)
+{
+	*tf = (struct text_font){0};
+
+	if (pack_font != NULL) {
+		tf->pack = pack_font;
+		tf->width = pack_font->width;
+		tf->height = pack_font->height;
+		return 0;
+	}
+
+#if defined(CONFIG_CHARACTER_FRAMEBUFFER)
+	int num_fonts;
+
+	STRUCT_SECTION_COUNT(cfb_font, &num_fonts);
+	if (font_idx >= num_fonts) {
+		return -ENOENT;
+	}
+
+	STRUCT_SECTION_GET(cfb_font, font_idx, &tf->cfb);
+	if (!(tf->cfb->caps & CFB_FONT_MONO_VPACKED)) {
+		return -ENOTSUP;
+	}
+	tf->width = tf->cfb->width;
+	tf->height = tf->cfb->height;
+	tf->reverse = !(tf->cfb->caps & CFB_FONT_MSB_FIRST);
+	return 0;
+#else
+	/* CFB fonts are not built in, only font pack fonts */
+	return -ENOENT;
+#endif
+}
+
+static int utf8_len(const char *str)
+{
+	int len = 0;
+
+	for (; *str != '\0'; len++) {
+		utf8_next(&str);
+	}
+	return len;
+}
+
+static inline const uint8_t *text_find_glyph(const struct text_font *tf, uint16_t c)
+{
+	return tf->cfb ? cfb_find_glyph(tf->cfb, c) : pack_find_glyph(tf->pack, c);
+}
+
+/* Draw a line of text into a surface, clipped to its columns and bottom edge */
+static void render_text(const struct surface *s, const struct text_font *tf, const char *str,
+			int x, int y, enum display_rop rop)
+{
+	int end = s->x0 + s->width;
+
+	if (y >= s->height) {
+		return;
+	}
+
+	for (int gx = x; *str != '\0' && gx < end; gx += tf->width) {
+		uint16_t c = utf8_next(&str);
+
+		if (gx + tf->width <= s->x0) {
+			continue;
+		}
+
+		const uint8_t *glyph = text_find_glyph(tf, c);
+
+		if (glyph != NULL) {
+			draw_glyph(s, tf, glyph, gx, y, MAX(gx, s->x0), MIN(gx + tf->width, end) - 1,
+				   rop);
+		}
+	}
+}
+
+int display_draw_text(const struct device *dev, const char *str, uint16_t x, uint16_t y,
+		      enum display_rop rop, struct display_rect *bbox)
+{
+	struct text_font tf;
+	int err = text_font_get(dev, &tf);
+
+	if (err) {
+		return err;
+	}
+
+	set_bbox(bbox, x, y, x + utf8_len(str) * tf.width - 1, y + tf.height - 1);
+	if (fb.buf != NULL) {
+		render_text(&fb, &tf, str, x, y, rop);
+	}
+
+	return 0;
+}
+
+/* --- Text cache --- */
+
+BUILD_ASSERT(DISPLAY_TEXT_CACHE_BYTES <= UINT16_MAX, "cache offsets are 16-bit");
+
+/*
+ * A text run rendered at its row phase (y % 8), so placing it again is a
+ * page-aligned block copy. Keyed by string, font and phase. The bitmap is
+ * followed in the pool by the string's len bytes, which are compared on
+ * every hash match so a collision is never drawn as the wrong text.
+ */
+struct text_cache_entry {
+	uint32_t hash;
+	uintptr_t font;
+	uint32_t last_used;
+	uint16_t len;
+	uint16_t offset;
+	uint16_t width;
+	uint8_t pages;
+	uint8_t phase;
+	bool used;
+};
+
+static uint8_t cache_pool[DISPLAY_TEXT_CACHE_BYTES];
+static struct text_cache_entry cache[DISPLAY_TEXT_CACHE_ENTRIES];
+static uint16_t cache_used; /* Bitmaps are packed from the start of cache_pool */
+static uint32_t cache_clock;
+static struct display_text_cache_stats cache_stats;
+
+static inline uint16_t cache_size(const struct text_cache_entry *e)
+{
+	return e->width * e->pages + e->len;
+}
+
+static inline uint8_t *cache_key(const struct text_cache_entry *e)
+{
+	return &cache_pool[e->offset + e->width * e->pages];
+}
+
+/*
+ * A cached run is merged as one block, so a missing glyph would clear its
+ * cell where display_draw_text() leaves it untouched. Such text is never
+ * cached.
+ */
+static bool text_glyphs_present(const struct text_font *tf, const char *str)
+{
+	while (*str != '\0') {
+		if (text_find_glyph(tf, utf8_next(&str)) == NULL) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static uint32_t fnv1a(const char *str, uint16_t *len)
+{
+	uint32_t hash = 2166136261U;
+	const char *p = str;
+
+	for (; *p != '\0'; p++) {
+		hash = (hash ^ (uint8_t)*p) * 16777619U;
+	}
+	*len = p - str;
+	return hash;
+}
+
+static void cache_evict(struct text_cache_entry *victim)
+{
+	uint16_t size = cache_size(victim);
+	uint16_t end = victim->offset + size;
+
+	/* Keep the pool packed: slide later bitmaps down over the freed space */
+	memmove(&cache_pool[victim->offset], &cache_pool[end], cache_used - end);
+	for (int i = 0; i < ARRAY_SIZE(cache); i++) {
+		if (cache[i].used && cache[i].offset >= end) {
+			cache[i].offset -= size;
+		}
+	}
+
+	cache_used -= size;
+	victim->used = false;
+	cache_stats.evictions++;
+	cache_stats.entries--;
+}
+
+/* Make room for size bytes by dropping least recently used runs */
+static struct text_cache_entry *cache_alloc(uint16_t size)
+{
+	for (;;) {
+		struct text_cache_entry *slot = NULL;
+		struct text_cache_entry *lru = NULL;
+
+		for (int i = 0; i < ARRAY_SIZE(cache); i++) {
+			if (!cache[i].used) {
+				slot = slot ? slot : &cache[i];
+			} else if (lru == NULL || cache[i].last_used < lru->last_used) {
+				lru = &cache[i];
+			}
+		}
+
+		if (slot != NULL && cache_used + size <= sizeof(cache_pool)) {
+			slot->used = true;
+			slot->offset = cache_used;
+			cache_used += size;
+			cache_stats.entries++;
+			return slot;
+		}
+		if (lru == NULL) {
+			return NULL;
+		}
+		cache_evict(lru);
+	}
+}
+
+int display_draw_text_cached(const struct device *dev, const char *str, uint16_t x, uint16_t y,
+			     enum display_rop rop, struct display_rect *bbox)
+{
+	struct text_font tf;
+	int err = text_font_get(dev, &tf);
+
+	if (err) {
+		return err;
+	}
+
+	uint16_t len;
+	uint32_t hash = fnv1a(str, &len);
+	uintptr_t font = tf.pack ? (uintptr_t)tf.pack : font_idx;
+	int width = utf8_len(str) * tf.width;
+	int phase = y % 8;
+	int pages = (phase + tf.height + 7) / 8;
+	struct text_cache_entry *e = NULL;
+
+	set_bbox(bbox, x, y, x + width - 1, y + tf.height - 1);
+	if (fb.buf == NULL || width == 0) {
+		return 0;
+	}
+
+	for (int i = 0; i < ARRAY_SIZE(cache); i++) {
+		if (cache[i].used && cache[i].hash == hash && cache[i].len == len &&
+		    cache[i].width == width &&
+		    cache[i].font == font && cache[i].phase == phase &&
+		    memcmp(cache_key(&cache[i]), str, len) == 0) {
+			e = &cache[i];
+			break;
+		}
+	}
+
+	if (e != NULL) {
+		cache_stats.hits++;
+	} else {
+		cache_stats.misses++;
+		if (width * pages + len > sizeof(cache_pool) || width > UINT16_MAX ||
+		    !text_glyphs_present(&tf, str)) {
+			render_text(&fb, &tf, str, x, y, rop);
+			return 0;
+		}
+
+		e = cache_alloc(width * pages + len);
+		e->hash = hash;
+		e->font = font;
+		e->len = len;
+		e->width = width;
+		e->pages = pages;
+		e->phase = phase;
+		memcpy(cache_key(e), str, len);
+
+		struct surface run = {&cache_pool[e->offset], 0, width, pages * 8};
+
+		memset(run.buf, 0, width * pages);
+		render_text(&run, &tf, str, 0, phase, DISPLAY_ROP_OR);
+	}
+	e->last_used = ++cache_clock;
+
+	/* Copy page rows straight into place, masking off rows outside the text */
+	int c0 = MAX(x, fb.x0);
+	int n = MIN(x + width, fb.x0 + fb.width) - c0;
+	int first = y / 8;
+
+	for (int k = 0; k < e->pages && first + k < fb.height / 8 && n > 0; k++) {
+		int page = first + k;
+
+		merge_page_row(fb_at(page, c0), NULL, &cache_pool[e->offset + k * width + c0 - x],
+			       n, 0, page_rows(page, y, y + tf.height - 1), 0, rop);
+	}
+
+	return 0;
+}
+
+void display_text_cache_get_stats(struct display_text_cache_stats *stats)
+{
+	*stats = cache_stats;
+	stats->bytes_used = cache_used;
+}
+
+/* --- Dithering --- */
+
+/* 8x8 Bayer matrix, thresholds 0..63 */
+static const uint8_t bayer8[8][8] = {
+	{0, 32, 8, 40, 2, 34, 10, 42},	{48, 16, 56, 24, 50, 18, 58, 26},
+	{12, 44, 4, 36, 14, 46, 6, 38},	{60, 28, 52, 20, 62, 30, 54, 22},
+	{3, 35, 11, 43, 1, 33, 9, 41},	{51, 19, 59, 27, 49, 17, 57, 25},
+	{15, 47, 7, 39, 13, 45, 5, 37},	{63, 31, 55, 23, 61, 29, 53, 21},
+};
+
+/*
+ * Image being dithered, one row at a time. Floyd-Steinberg keeps a single
+ * row of error numerators (sixteenths of a gray level): entries left of
+ * the current pixel already hold the next row's error, the rest still
+ * hold this row's.
+ */
+static struct {
+	int x;
+	int y;
+	int width;
+	enum display_dither mode;
+	int16_t err[DISPLAY_DITHER_MAX_WIDTH];
+} dither;
+
+int display_dither_begin(const struct device *dev, uint16_t x, uint16_t y, uint16_t width,
+			 enum display_dither mode)
+{
+	if (width == 0 || width > DISPLAY_DITHER_MAX_WIDTH) {
+		return -EINVAL;
+	}
+
+	dither.x = x;
+	dither.y = y;
+	dither.width = width;
+	dither.mode = mode;
+	memset(dither.err, 0, width * sizeof(dither.err[0]));
+	return 0;
+}
+
+/* Set a pixel where the dithered output is black, clear it where white */
+static inline void dither_put(uint8_t *p, uint8_t bit, bool black)
+{
+	*p = black ? (*p | bit) : (*p & ~bit);
+}
+
+/*
+ * Dither samples [i0, i1) of the row, whose pixels start at row; the rest
+ * fall outside the framebuffer.
+ */
+static void dither_bayer(const uint8_t *gray, uint8_t *row, uint8_t bit, int i0, int i1)
+{
+	const uint8_t *threshold = bayer8[dither.y % 8];
+
+	for (int i = i0; i < i1; i++) {
+		/* 0..63 scaled to 2..254, so pure black and white stay solid */
+		dither_put(&row[i - i0], bit, gray[i] < threshold[(dither.x + i) % 8] * 4 + 2);
+	}
+}
+
+/* Every sample feeds the error buffer; only [i0, i1) are written */
+static void dither_floyd_steinberg(const uint8_t *gray, uint8_t *row, uint8_t bit, int i0, int i1)
+{
+	int16_t *err = dither.err;
+	int right = 0;	  /* 7/16 of the previous pixel's error */
+	int below = 0;	  /* Next row at x: 1/16 of pixel x - 1 */
+	int pending = 0;  /* Next row at x - 1: 1/16 of x - 2 plus 5/16 of x - 1 */
+
+	for (int i = 0; i < dither.width; i++) {
+		int v = (gray[i] * 16 + err[i] + right + 8) >> 4;
+		bool black = v < 128;
+		int e = v - (black ? 0 : 255);
+
+		if (i >= i0 && i < i1) {
+			dither_put(&row[i - i0], bit, black);
+		}
+		if (i > 0) {
+			err[i - 1] = pending + 3 * e;
+		}
+		pending = below + 5 * e;
+		below = e;
+		right = 7 * e;
+	}
+	err[dither.width - 1] = pending;
+}
+
+int display_dither_row(const struct device *dev, const uint8_t *gray)
+{
+	if (dither.width == 0) {
+		return -EINVAL;
+	}
+	int i0 = MAX(fb.x0 - dither.x, 0);
+	int i1 = MIN(fb.x0 + fb.width - dither.x, dither.width);
+
+	if (fb.buf != NULL && dither.y < fb.height) {
+		uint8_t *row = i0 < i1 ? fb_at(dither.y / 8, dither.x + i0) : NULL;
+		uint8_t bit = 0x80 >> (dither.y % 8);
+
+		if (dither.mode == DISPLAY_DITHER_BAYER) {
+			dither_bayer(gray, row, bit, i0, i1);
+		} else {
+			dither_floyd_steinberg(gray, row, bit, i0, i1);
+		}
+	}
+
+	dither.y++;
+	return 0;
+}
+
+#if defined(CONFIG_EPD_BANDED)
+
+/* --- Band rendering --- */
+
+/* One band in the CFB layout, a full-height strip of EPD_BAND_ROWS columns */
+static uint8_t band_buf[EPD_BAND_ROWS * (EPD_LOGICAL_HEIGHT / 8)];
+
+static void render_band(const struct device *dev, int x, display_band_draw_t draw,
+			void *user_data)
+{
+	fb.buf = band_buf;
+	fb.x0 = x;
+	fb.width = MIN(EPD_BAND_ROWS, screen_width - x);
+	memset(band_buf, 0, fb.width * (fb.height / 8));
+	draw(dev, user_data);
+	if (inverted) {
+		span_apply(band_buf, fb.width * (fb.height / 8), 0xFF, DISPLAY_PEN_INVERT);
+	}
+}
+
+int display_render_bands(const struct device *dev, display_band_draw_t draw, void *user_data)
+{
+	struct surface screen = fb;
+	int err = 0;
+
+	if (screen_width == 0 || fb.height > EPD_LOGICAL_HEIGHT) {
+		return -EIO;
+	}
+
+	epd_graphics_band_begin(dev);
+	for (int x = 0; x < screen_width && err == 0; x += EPD_BAND_ROWS) {
+		render_band(dev, x, draw, user_data);
+		err = epd_graphics_band_write(dev, x, fb.width, band_buf);
+	}
+	if (err == 0) {
+		err = epd_graphics_band_update(dev);
+	}
+
+	/* Old-image RAM only needs the bands that changed, drawn once more */
+	for (int x = 0; x < screen_width && err == 0; x += EPD_BAND_ROWS) {
+		if (epd_graphics_band_changed(dev, x)) {
+			render_band(dev, x, draw, user_data);
+			err = epd_graphics_band_write(dev, x, fb.width, band_buf);
+		}
+	}
+
+	fb = screen;
+	return err;
+}
+
+#endif /* CONFIG_EPD_BANDED */
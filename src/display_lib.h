@@ -4,6 +4,99 @@
 
 #include <zephyr/device.h>
 #include <stdint.h>
+#include "epd_panel.h"
+
+/* RAM for text runs cached by display_draw_text_cached(), in bytes */
+#define DISPLAY_TEXT_CACHE_BYTES CONFIG_DISPLAY_TEXT_CACHE_BYTES
+
+/* Maximum number of text runs held by the cache */
+#define DISPLAY_TEXT_CACHE_ENTRIES CONFIG_DISPLAY_TEXT_CACHE_ENTRIES
+
+/* Widest row display_dither_row() accepts; sets the error buffer size */
+#ifndef DISPLAY_DITHER_MAX_WIDTH
+#define DISPLAY_DITHER_MAX_WIDTH EPD_LOGICAL_WIDTH
+#endif
+
+/** @brief How a primitive modifies the pixels it covers */
+enum display_pen {
+	DISPLAY_PEN_SET,    /**< Turn pixels on (foreground) */
+	DISPLAY_PEN_CLEAR,  /**< Turn pixels off (background) */
+	DISPLAY_PEN_INVERT, /**< Toggle pixels */
+};
+
+/** @brief Raster operation combining a bitmap with the framebuffer */
+enum display_rop {
+	DISPLAY_ROP_COPY, /**< dst = src */
+	DISPLAY_ROP_AND,  /**< dst = dst & src */
+	DISPLAY_ROP_OR,   /**< dst = dst | src */
+	DISPLAY_ROP_XOR,  /**< dst = dst ^ src */
+};
+
+/** @brief Axis-aligned rectangle in display coordinates */
+struct display_rect {
+	uint16_t x;
+	uint16_t y;
+	uint16_t w;
+	uint16_t h;
+};
+
+/**
+ * @brief 1-bit bitmap in framebuffer-native layout
+ *
+ * Vertical tiled like the CFB buffer: byte (y / 8) * width + x holds
+ * eight vertical pixels, MSB on top.
+ */
+struct display_bitmap {
+	const uint8_t *data;
+	uint16_t width;
+	uint16_t height;
+};
+
+/**
+ * @brief Fixed-cell font from a generated font pack
+ *
+ * Produced by tools/gen_font_pack.py. Only the characters an application
+ * uses are present; identical glyph bitmaps are stored once in a pool
+ * shared by every font of the pack. Bitmaps are vertically packed like
+ * CFB fonts (column by column, MSB on top).
+ */
+struct display_font {
+	uint8_t width;
+	uint8_t height;
+	uint16_t num_glyphs;
+	/** Character codes in ascending order */
+	const uint16_t *chars;
+	/** Offset of each character's bitmap in @p bitmaps */
+	const uint32_t *offsets;
+	const uint8_t *bitmaps;
+};
+
+/** @brief Grayscale to 1-bit conversion */
+enum display_dither {
+	/** 8x8 ordered dither, stable under partial redraws */
+	DISPLAY_DITHER_BAYER,
+	/** Error diffusion, smoother gradients */
+	DISPLAY_DITHER_FLOYD_STEINBERG,
+};
+
+/**
+ * @brief Draws one frame for display_render_bands()
+ *
+ * Called several times per frame, each time with the framebuffer limited
+ * to one band; it must draw the same content every time.
+ */
+typedef void (*display_band_draw_t)(const struct device *dev, void *user_data);
+
+/** @brief Text cache counters */
+struct display_text_cache_stats {
+	uint32_t hits;
+	uint32_t misses;
+	uint32_t evictions;
+	/** Text runs currently cached */
+	uint16_t entries;
+	/** Bytes of bitmaps and strings in use out of DISPLAY_TEXT_CACHE_BYTES */
+	uint16_t bytes_used;
+};
 
 /**
  * @brief Initialize the display library.
@@ -16,6 +109,11 @@
  * - Clears the framebuffer.
  * - Sets the default font.
  *
+ * With CONFIG_EPD_BANDED, CFB and its framebuffer are left alone and
+ * frames can only be drawn with display_render_bands(). CFB itself is then
+ * optional: without CONFIG_CHARACTER_FRAMEBUFFER, text needs a font pack
+ * font.
+ *
  * @param dev Pointer to the display device instance to initialize.
  *
  * @return 0 on success.
@@ -24,14 +122,20 @@
  */
 int display_lib_init(const struct device *dev);
 
+#if !defined(CONFIG_EPD_BANDED)
 /**
  * @brief Print text to the display buffer
+ *
+ * Draws with cfb_print(), so it is not available with CONFIG_EPD_BANDED;
+ * use display_draw_text() there.
+ *
  * @param dev Display device instance
  * @param str Text string to print
  * @param x X coordinate
  * @param y Y coordinate
  */
 void display_print(const struct device *dev, const char *str, uint16_t x, uint16_t y);
+#endif
 
 /**
  * @brief Set the active CFB font by index
@@ -43,8 +147,30 @@ void display_print(const struct device *dev, const char *str, uint16_t x, uint16
  */
 int display_set_font(const struct device *dev, uint8_t font_idx);
 
+/**
+ * @brief Get the cell size of a CFB font
+ *
+ * Unlike cfb_get_font_size(), also works when CONFIG_EPD_BANDED leaves
+ * CFB uninitialized.
+ *
+ * @param dev Display device instance
+ * @param font_idx Font index as configured in Zephyr
+ * @param width Receives the glyph width in pixels
+ * @param height Receives the glyph height in pixels
+ *
+ * @return 0 on success.
+ * @retval -EINVAL If the font index is not available.
+ */
+int display_get_font_size(const struct device *dev, uint8_t font_idx, uint8_t *width,
+			  uint8_t *height);
+
+#if !defined(CONFIG_EPD_BANDED)
 /**
  * @brief Draw a rectangle to the display buffer
+ *
+ * Draws with cfb_draw_rect(), so it is not available with
+ * CONFIG_EPD_BANDED; use display_fill_rect() or display_draw_line() there.
+ *
  * @param dev Display device instance
  * @param x X coordinate of top-left corner
  * @param y Y coordinate of top-left corner
@@ -52,11 +178,256 @@ int display_set_font(const struct device *dev, uint8_t font_idx);
  * @param h Height
  */
 void display_draw_rect(const struct device *dev, uint16_t x, uint16_t y, uint16_t w, uint16_t h);
+#endif
+
+/**
+ * @brief Fill a rectangle in the display buffer
+ * @param dev Display device instance
+ * @param x X coordinate of top-left corner
+ * @param y Y coordinate of top-left corner
+ * @param w Width
+ * @param h Height
+ * @param pen Pixel operation
+ * @param bbox If not NULL, receives the area touched after clipping
+ */
+void display_fill_rect(const struct device *dev, uint16_t x, uint16_t y, uint16_t w, uint16_t h,
+		       enum display_pen pen, struct display_rect *bbox);
+
+/**
+ * @brief Draw a one pixel wide line between two points (inclusive)
+ * @param dev Display device instance
+ * @param x0 X coordinate of the start point
+ * @param y0 Y coordinate of the start point
+ * @param x1 X coordinate of the end point
+ * @param y1 Y coordinate of the end point
+ * @param pen Pixel operation
+ * @param bbox If not NULL, receives the area touched after clipping
+ */
+void display_draw_line(const struct device *dev, uint16_t x0, uint16_t y0, uint16_t x1,
+		       uint16_t y1, enum display_pen pen, struct display_rect *bbox);
+
+/**
+ * @brief Draw a circle outline
+ * @param dev Display device instance
+ * @param cx X coordinate of the centre
+ * @param cy Y coordinate of the centre
+ * @param r Radius
+ * @param pen Pixel operation
+ * @param bbox If not NULL, receives the area touched after clipping
+ */
+void display_draw_circle(const struct device *dev, uint16_t cx, uint16_t cy, uint16_t r,
+			 enum display_pen pen, struct display_rect *bbox);
 
+/**
+ * @brief Draw a filled circle
+ * @param dev Display device instance
+ * @param cx X coordinate of the centre
+ * @param cy Y coordinate of the centre
+ * @param r Radius
+ * @param pen Pixel operation
+ * @param bbox If not NULL, receives the area touched after clipping
+ */
+void display_fill_circle(const struct device *dev, uint16_t cx, uint16_t cy, uint16_t r,
+			 enum display_pen pen, struct display_rect *bbox);
+
+/**
+ * @brief Combine a bitmap with the display buffer
+ * @param dev Display device instance
+ * @param bmp Source bitmap
+ * @param x X coordinate of the bitmap's top-left corner
+ * @param y Y coordinate of the bitmap's top-left corner
+ * @param rop Raster operation
+ * @param bbox If not NULL, receives the area touched after clipping
+ */
+void display_blit(const struct device *dev, const struct display_bitmap *bmp, uint16_t x,
+		  uint16_t y, enum display_rop rop, struct display_rect *bbox);
+
+/**
+ * @brief Use a font pack font for display_draw_text()
+ * @param dev Display device instance
+ * @param font Font from a generated font pack, or NULL to go back to the CFB font
+ *
+ * @return 0 on success.
+ * @retval -EINVAL If the font height is not a multiple of 8.
+ */
+int display_set_pack_font(const struct device *dev, const struct display_font *font);
+
+/**
+ * @brief Draw text with the active font at any pixel position
+ *
+ * Unlike display_print(), glyphs need not sit on the 8-pixel page grid:
+ * they are shifted into place with word-wide operations.
+ *
+ * @param dev Display device instance
+ * @param str Text string to draw (single line, UTF-8)
+ * @param x X coordinate of the first glyph's top-left corner
+ * @param y Y coordinate of the first glyph's top-left corner
+ * @param rop Raster operation, e.g. DISPLAY_ROP_OR to draw over a background
+ * @param bbox If not NULL, receives the area touched after clipping
+ *
+ * @return 0 on success.
+ * @retval -ENOENT If no font is available.
+ * @retval -ENOTSUP If the active font is not vertically packed.
+ */
+int display_draw_text(const struct device *dev, const char *str, uint16_t x, uint16_t y,
+		      enum display_rop rop, struct display_rect *bbox);
+
+/**
+ * @brief Draw text through the rendered-text cache
+ *
+ * Same output as display_draw_text(). The rendered run is kept in a small
+ * LRU cache keyed by string, font and y % 8, so redrawing the same label
+ * is a single block copy. Text with characters the font lacks is drawn
+ * uncached. Meant for labels, units and headers that repeat; text that
+ * changes every frame should use display_draw_text().
+ *
+ * @param dev Display device instance
+ * @param str Text string to draw (single line, UTF-8)
+ * @param x X coordinate of the first glyph's top-left corner
+ * @param y Y coordinate of the first glyph's top-left corner
+ * @param rop Raster operation
+ * @param bbox If not NULL, receives the area touched after clipping
+ *
+ * @return 0 on success.
+ * @retval -ENOENT If no font is available.
+ * @retval -ENOTSUP If the active font is not vertically packed.
+ */
+int display_draw_text_cached(const struct device *dev, const char *str, uint16_t x, uint16_t y,
+			     enum display_rop rop, struct display_rect *bbox);
+
+/**
+ * @brief Get text cache counters
+ * @param stats Destination for the counters
+ */
+void display_text_cache_get_stats(struct display_text_cache_stats *stats);
+
+/**
+ * @brief Start dithering a grayscale image into the framebuffer
+ *
+ * Rows are then fed top to bottom with display_dither_row(), so an image
+ * can come from flash or a decoder without ever being held in RAM.
+ *
+ * @param dev Display device instance
+ * @param x X coordinate of the image's left edge
+ * @param y Y coordinate of the image's first row
+ * @param width Pixels per row, at most DISPLAY_DITHER_MAX_WIDTH
+ * @param mode Dithering algorithm
+ *
+ * @return 0 on success, -EINVAL if width is 0 or too large.
+ */
+int display_dither_begin(const struct device *dev, uint16_t x, uint16_t y, uint16_t width,
+			 enum display_dither mode);
+
+/**
+ * @brief Dither the next image row into the framebuffer
+ *
+ * Pixels outside the display are dropped.
+ *
+ * @param dev Display device instance
+ * @param gray width 8-bit samples, 0 black to 255 white
+ *
+ * @return 0 on success, -EINVAL if display_dither_begin() was not called.
+ */
+int display_dither_row(const struct device *dev, const uint8_t *gray);
+
+#if defined(CONFIG_EPD_BANDED)
+/**
+ * @brief Render and send a frame one band at a time
+ *
+ * The draw callback is replayed for every band of EPD_BAND_ROWS logical
+ * columns into a small band buffer that starts cleared; each band is
+ * converted to the panel layout and written before the next is drawn, and
+ * the panel is refreshed once. The bands that changed, found by checksum,
+ * are then drawn a second time into the panel's old-image RAM; the others
+ * are not sent at all. No panel-sized buffer exists anywhere, so display
+ * memory is bounded by the band size. Only available with
+ * CONFIG_EPD_BANDED.
+ *
+ * The checksum is a CRC32 of the band, not the band itself: in the rare
+ * case that a changed band has the same CRC it is skipped and stays stale
+ * until it changes again or a forced full refresh
+ * (epd_refresh_policy_force_full()) resends every band.
+ *
+ * Inside the callback only display_lib primitives may be used (fills,
+ * lines, circles, blits, display_draw_text*, dithering). Bounding boxes are
+ * reported in display coordinates as usual.
+ *
+ * @param dev Display device instance
+ * @param draw Callback drawing the whole frame
+ * @param user_data Passed to draw
+ *
+ * @return 0 on success.
+ * @retval -EIO If display_lib_init() has not succeeded.
+ */
+int display_render_bands(const struct device *dev, display_band_draw_t draw, void *user_data);
+#endif
+
+#if !defined(CONFIG_EPD_BANDED)
+/**
+ * @brief Scroll the contents of a region
+ *
+ * Existing pixels are moved with block/word operations; the band that
+ * scrolls into view is cleared and reported through @p exposed so only
+ * the new content needs to be drawn. Follow with display_flush_region()
+ * to send just the region to the panel. Needs the framebuffer, so it is
+ * not available with CONFIG_EPD_BANDED.
+ *
+ * @param dev Display device instance
+ * @param region Area to scroll
+ * @param dx Horizontal distance in pixels, negative moves content left
+ * @param dy Vertical distance in pixels, negative moves content up
+ * @param exposed If not NULL, receives the cleared band
+ *
+ * @return 0 on success.
+ * @retval -EINVAL If both dx and dy are non-zero.
+ */
+int display_scroll(const struct device *dev, const struct display_rect *region, int dx, int dy,
+		   struct display_rect *exposed);
+#endif
+
+/**
+ * @brief Swap black and white in every frame sent to the panel
+ *
+ * Wraps cfb_framebuffer_invert(), which only affects
+ * cfb_framebuffer_finalize(), and records the state so
+ * display_flush_region() sends the same polarity. Call this rather than
+ * cfb_framebuffer_invert(). With CONFIG_EPD_BANDED it applies to
+ * display_render_bands() instead. Each call toggles the state.
+ *
+ * @param dev Display device instance
+ *
+ * @return 0 on success, negative errno from cfb_framebuffer_invert() otherwise.
+ */
+int display_invert(const struct device *dev);
+
+#if !defined(CONFIG_EPD_BANDED)
 /**
  * @brief Flush the display buffer to the hardware (trigger refresh)
+ *
+ * Not available with CONFIG_EPD_BANDED, which has no framebuffer; frames
+ * are sent by display_render_bands() there.
+ *
  * @param dev Display device instance
  */
 void display_flush(const struct device *dev);
 
+/**
+ * @brief Send part of the display buffer to the hardware (trigger refresh)
+ *
+ * The area is widened to whole 8-row pages. Only the panel rows under the
+ * area are converted and compared, and only panel RAM for pixels that
+ * changed is rewritten, so small areas cost only a few hundred bytes of
+ * transfer. The region is shown with a partial refresh; the refresh policy
+ * turns it into a full refresh only when a ghosting limit is reached.
+ * Colours are swapped as in display_flush() after display_invert(). Not
+ * available with CONFIG_EPD_BANDED.
+ *
+ * @param dev Display device instance
+ * @param area Area to send, e.g. a bounding box reported by a primitive
+ *
+ * @return 0 on success, negative errno from the display driver otherwise.
+ */
+int display_flush_region(const struct device *dev, const struct display_rect *area);
+#endif
+
 #endif /* DISPLAY_LIB_H */
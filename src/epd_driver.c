@@ -1,4 +1,5 @@
 /* src/epd_driver.c */
+#include <string.h>
 #include <zephyr/kernel.h>
 #include <zephyr/device.h>
 #include <zephyr/drivers/gpio.h>
@@ -16,6 +17,9 @@ static const struct gpio_dt_spec busy_gpio = GPIO_DT_SPEC_GET(DT_NODELABEL(busy_
 static const struct gpio_dt_spec rst_gpio = GPIO_DT_SPEC_GET(DT_NODELABEL(reset_pin), gpios);
 static const struct gpio_dt_spec dc_gpio = GPIO_DT_SPEC_GET(DT_NODELABEL(dc_pin), gpios);
 
+/* LUT currently held by the controller */
+static enum epd_refresh_mode loaded_lut = EPD_REFRESH_FULL;
+
 static void epd_reset(void)
 {
     if (!gpio_is_ready_dt(&rst_gpio)) return;
@@ -44,6 +48,33 @@ static void epd_send_data(uint8_t data)
     spi_write_dt(&spi_dev, &buf_set);
 }
 
+static void epd_send_data_buf(const uint8_t *data, size_t len)
+{
+    /* DC High = Data */
+    gpio_pin_set_dt(&dc_gpio, 0);
+    struct spi_buf buf = {.buf = (void *)data, .len = len};
+    struct spi_buf_set buf_set = {.buffers = &buf, .count = 1};
+    spi_write_dt(&spi_dev, &buf_set);
+}
+
+/*
+ * Images live in flash, which SPIM EasyDMA cannot read; nrfx would bounce
+ * them through its own few-byte buffer, so copy them in larger chunks.
+ */
+static void epd_send_data_const(const uint8_t *data, size_t len)
+{
+    static uint8_t chunk[EPD_IMAGE_CHUNK];
+
+    while (len > 0) {
+        size_t n = MIN(len, sizeof(chunk));
+
+        memcpy(chunk, data, n);
+        epd_send_data_buf(chunk, n);
+        data += n;
+        len -= n;
+    }
+}
+
 static void epd_wait_busy(void)
 {
     LOG_INF("Waiting for BUSY...");
@@ -58,6 +89,83 @@ static void epd_wait_busy(void)
     LOG_INF("BUSY Released.");
 }
 
+/* Restrict RAM access to X bytes [xs, xe] and rows [ys, ye], cursor at the start */
+static void epd_set_window(uint8_t xs, uint8_t xe, uint16_t ys, uint16_t ye)
+{
+    epd_send_cmd(0x44); // Set Ram-X
+    epd_send_data(xs);
+    epd_send_data(xe);
+
+    epd_send_cmd(0x45); // Set Ram-Y
+    epd_send_data(ys & 0xFF);
+    epd_send_data(ys >> 8);
+    epd_send_data(ye & 0xFF);
+    epd_send_data(ye >> 8);
+
+    epd_send_cmd(0x4E); // Ram-X counter
+    epd_send_data(xs);
+    epd_send_cmd(0x4F); // Ram-Y counter
+    epd_send_data(ys & 0xFF);
+    epd_send_data(ys >> 8);
+}
+
+/*
+ * Fill the current RAM window on the controller itself.
+ * A[7] is the fill value; step height/width 0x7 are larger than the
+ * panel, so the pattern never toggles and the fill is uniform.
+ */
+static void epd_auto_write(uint8_t cmd, uint8_t value)
+{
+    epd_send_cmd(cmd); // 0x46 Red RAM, 0x47 B/W RAM
+    epd_send_data((value ? 0x80 : 0x00) | 0x77);
+    epd_wait_busy();
+}
+
+static bool epd_row_is_uniform(const uint8_t *row, uint8_t len, uint8_t value)
+{
+    for (int i = 0; i < len; i++) {
+        if (row[i] != value) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * Stream rows [ys, ye] of X bytes [xs, xe] into RAM. data starts at the
+ * window's first byte, pitch bytes per row. Windows narrower than the
+ * pitch are not contiguous, so their row slices go out as a scatter list,
+ * EPD_SPI_CHUNK rows at a time.
+ */
+static void epd_stream_window(uint8_t ram_cmd, const uint8_t *data, size_t pitch, uint8_t xs,
+                              uint8_t xe, uint16_t ys, uint16_t ye)
+{
+    uint8_t len = xe - xs + 1;
+
+    epd_set_window(xs, xe, ys, ye);
+    epd_send_cmd(ram_cmd); // Write RAM
+
+    if (len == pitch) {
+        epd_send_data_buf(data, (ye - ys + 1) * pitch);
+        return;
+    }
+
+    struct spi_buf bufs[EPD_SPI_CHUNK];
+
+    gpio_pin_set_dt(&dc_gpio, 0);
+    for (uint16_t y = ys; y <= ye;) {
+        size_t count = 0;
+
+        for (; count < EPD_SPI_CHUNK && y <= ye; count++, y++) {
+            bufs[count].buf = (void *)&data[(y - ys) * pitch];
+            bufs[count].len = len;
+        }
+
+        struct spi_buf_set buf_set = {.buffers = bufs, .count = count};
+        spi_write_dt(&spi_dev, &buf_set);
+    }
+}
+
 int epd_hardware_init(void)
 {
     if (!spi_is_ready_dt(&spi_dev)) {
@@ -77,7 +185,7 @@ int epd_hardware_init(void)
     return 0;
 }
 
-void epd_init_v4(void)
+void epd_init_panel(void)
 {
     epd_reset();
     epd_wait_busy();
@@ -86,59 +194,205 @@ void epd_init_v4(void)
     
     epd_send_cmd(0x12); // SW Reset
     epd_wait_busy();
+    loaded_lut = EPD_REFRESH_FULL;
 
     epd_send_cmd(0x01); // Driver output control
-    epd_send_data(0xF9);
-    epd_send_data(0x00);
+    epd_send_data((EPD_HEIGHT - 1) & 0xFF); // Gate lines - 1
+    epd_send_data((EPD_HEIGHT - 1) >> 8);
     epd_send_data(0x00);
 
     epd_send_cmd(0x11); // Data entry mode
     epd_send_data(0x03); // X increment, Y increment
 
     epd_send_cmd(0x3C); // BorderWavefrom
-    epd_send_data(0x05);
+    epd_send_data(EPD_BORDER_WAVEFORM);
 
     epd_send_cmd(0x18); // Temp Sensor
     epd_send_data(0x80); // Internal
 
-    /* Soft Start Patch for V4 */
+#ifdef EPD_UPDATE_CTRL1
+    static const uint8_t update_ctrl1[] = EPD_UPDATE_CTRL1;
+
+    epd_send_cmd(0x21); // Display Update Control 1
+    epd_send_data_buf(update_ctrl1, sizeof(update_ctrl1));
+#endif
+
+#ifdef EPD_SOFT_START
+    static const uint8_t soft_start[] = EPD_SOFT_START;
+
     LOG_INF("Sending Soft Start Patch...");
-    epd_send_cmd(0x0C); 
-    epd_send_data(0xAE);
-    epd_send_data(0xC7);
-    epd_send_data(0xC3);
-    epd_send_data(0xC0);
-    epd_send_data(0x80); 
+    epd_send_cmd(0x0C); // Booster Soft Start
+    epd_send_data_buf(soft_start, sizeof(soft_start));
+#endif
 
-    epd_send_cmd(0x44); // Set Ram-X
-    epd_send_data(0x00);
-    epd_send_data(0x0F); // 128/8 - 1 = 15
+    epd_set_window(0x00, EPD_WIDTH_BYTES - 1, 0, EPD_HEIGHT - 1);
 
-    epd_send_cmd(0x45); // Set Ram-Y
-    epd_send_data(0x00); // Start 0
-    epd_send_data(0x00);
-    epd_send_data(0xF9); // End 249
-    epd_send_data(0x00);
+    /* Both RAM planes start white, filled on-chip rather than over SPI */
+    epd_auto_write(0x46, 0xFF);
+    epd_auto_write(0x47, 0xFF);
 }
 
-void epd_display_framebuffer(const uint8_t *buffer, size_t size)
+/*
+ * Upload a window to B/W (0x24) or old (0x26) RAM. Runs of at least
+ * EPD_AUTO_WRITE_MIN_ROWS rows that are all white or all black across the
+ * window are filled with auto-write instead of being streamed; everything
+ * else goes out in one window per run.
+ */
+static void epd_write_rows(uint8_t ram_cmd, const uint8_t *data, size_t pitch, uint8_t xs,
+                           uint8_t xe, uint16_t ys, uint16_t ye)
 {
-    /* Set counters to 0,0 */
-    epd_send_cmd(0x4E); 
-    epd_send_data(0x00);
-    epd_send_cmd(0x4F); 
-    epd_send_data(0x00);
-    epd_send_data(0x00);
-    
-    epd_send_cmd(0x24); // Write RAM
-    for (size_t i = 0; i < size; i++) {
-        epd_send_data(buffer[i]);
+    uint8_t auto_cmd = (ram_cmd == EPD_RAM_BW) ? 0x47 : 0x46;
+    uint8_t len = xe - xs + 1;
+    uint16_t y = ys;
+    uint16_t pending = ys; // first row not yet sent
+
+    while (y <= ye) {
+        const uint8_t *row = &data[(y - ys) * pitch];
+        uint8_t value = row[0];
+        uint16_t end = y;
+
+        if (value == 0x00 || value == 0xFF) {
+            while (end <= ye &&
+                   epd_row_is_uniform(&data[(end - ys) * pitch], len, value)) {
+                end++;
+            }
+        }
+
+        if (end - y < EPD_AUTO_WRITE_MIN_ROWS) {
+            y = MAX(end, y + 1);
+            continue;
+        }
+
+        if (pending < y) {
+            epd_stream_window(ram_cmd, &data[(pending - ys) * pitch], pitch, xs, xe, pending,
+                              y - 1);
+        }
+
+        epd_set_window(xs, xe, y, end - 1);
+        epd_auto_write(auto_cmd, value);
+        y = end;
+        pending = end;
     }
-    
-    LOG_INF("Activating Display...");
+
+    if (pending <= ye) {
+        epd_stream_window(ram_cmd, &data[(pending - ys) * pitch], pitch, xs, xe, pending, ye);
+    }
+}
+
+#ifdef EPD_PARTIAL_LUT
+static void epd_load_partial_lut(void)
+{
+    static const uint8_t lut[] = EPD_PARTIAL_LUT;
+
+    BUILD_ASSERT(sizeof(lut) == 159, "153 LUT bytes and 6 voltage bytes");
+
+    epd_send_cmd(0x32); // Write LUT register
+    epd_send_data_buf(lut, 153);
+    epd_send_cmd(0x3F); // End option
+    epd_send_data(lut[153]);
+    epd_send_cmd(0x03); // Gate driving voltage
+    epd_send_data(lut[154]);
+    epd_send_cmd(0x04); // Source driving voltage
+    epd_send_data_buf(&lut[155], 3);
+    epd_send_cmd(0x2C); // VCOM
+    epd_send_data(lut[158]);
+
+#ifdef EPD_PARTIAL_OPTION
+    static const uint8_t option[] = EPD_PARTIAL_OPTION;
+
+    BUILD_ASSERT(sizeof(option) == 10, "0x37 takes 10 bytes");
+
+    epd_send_cmd(0x37); // Display option
+    epd_send_data_buf(option, sizeof(option));
+#endif
+}
+#endif
+
+void epd_update(enum epd_refresh_mode mode)
+{
+    uint8_t ctrl;
+
+#ifdef EPD_PARTIAL_CTRL1
+    static const uint8_t update_ctrl1[] = EPD_UPDATE_CTRL1;
+    static const uint8_t partial_ctrl1[] = EPD_PARTIAL_CTRL1;
+
+    BUILD_ASSERT(sizeof(update_ctrl1) == sizeof(partial_ctrl1), "0x21 takes the same bytes");
+
+    epd_send_cmd(0x21); // Display Update Control 1
+    epd_send_data_buf(mode == EPD_REFRESH_PARTIAL ? partial_ctrl1 : update_ctrl1,
+                      sizeof(update_ctrl1));
+#endif
+
+    switch (mode) {
+    case EPD_REFRESH_FAST:
+        if (loaded_lut != EPD_REFRESH_FAST) {
+            epd_send_cmd(0x1A); // Write temperature register
+            epd_send_data(EPD_FAST_TEMPERATURE);
+            epd_send_data(0x00);
+            epd_send_cmd(0x22);
+            epd_send_data(0x91); // Load LUT for that temperature
+            epd_send_cmd(0x20);
+            epd_wait_busy();
+        }
+        ctrl = 0xC7; // Display with the loaded LUT
+        break;
+    case EPD_REFRESH_PARTIAL:
+#ifdef EPD_PARTIAL_LUT
+        if (loaded_lut != EPD_REFRESH_PARTIAL) {
+            epd_load_partial_lut();
+        }
+        ctrl = 0xCF; // Display mode 2 with the loaded LUT
+#else
+        ctrl = 0xFF; // Load LUT from OTP + Display mode 2
+#endif
+        break;
+    default:
+        ctrl = 0xF7; // Load LUT from OTP + Display
+        break;
+    }
+
+    /* 0xF7/0xFF re-read the temperature sensor, replacing any other LUT */
+    loaded_lut = mode;
+
+    LOG_INF("Activating Display (mode %d)...", mode);
+    epd_send_cmd(0x3C); // BorderWavefrom
+    epd_send_data(mode == EPD_REFRESH_PARTIAL ? 0x80 : EPD_BORDER_WAVEFORM);
+
     epd_send_cmd(0x22); // Display Update Control 2
-    epd_send_data(0xF7); // Load LUT from OTP + Display
-    
+    epd_send_data(ctrl);
+
     epd_send_cmd(0x20); // Master Activation
     epd_wait_busy();
 }
+
+void epd_display_window(const uint8_t *buffer, uint8_t xs, uint8_t xe, uint16_t ys, uint16_t ye,
+                        enum epd_refresh_mode mode)
+{
+    const uint8_t *data = &buffer[ys * EPD_WIDTH_BYTES + xs];
+
+    epd_write_rows(EPD_RAM_BW, data, EPD_WIDTH_BYTES, xs, xe, ys, ye);
+    epd_update(mode);
+    epd_write_rows(EPD_RAM_OLD, data, EPD_WIDTH_BYTES, xs, xe, ys, ye);
+}
+
+void epd_write_ram(enum epd_ram ram, const uint8_t *data, size_t pitch, uint8_t xs, uint8_t xe,
+                   uint16_t ys, uint16_t ye)
+{
+    epd_write_rows(ram, data, pitch, xs, xe, ys, ye);
+}
+
+void epd_display_image(const struct epd_image *image, enum epd_refresh_mode mode)
+{
+    size_t len = (image->xe - image->xs + 1) * (image->ye - image->ys + 1);
+
+    /* The image is already packed for the window, so each plane is one stream */
+    epd_set_window(image->xs, image->xe, image->ys, image->ye);
+    epd_send_cmd(EPD_RAM_BW);
+    epd_send_data_const(image->data, len);
+
+    epd_update(mode);
+
+    epd_set_window(image->xs, image->xe, image->ys, image->ye);
+    epd_send_cmd(EPD_RAM_OLD);
+    epd_send_data_const(image->data, len);
+}
@@ -4,11 +4,44 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include "epd_panel.h"
 
-/* Display resolution */
-#define EPD_WIDTH       128
-#define EPD_HEIGHT      250
-#define EPD_WIDTH_BYTES (EPD_WIDTH / 8)
+/* Shortest run of uniform rows worth an on-chip auto-write instead of SPI */
+#define EPD_AUTO_WRITE_MIN_ROWS 8
+
+/* Rows per SPI scatter list when streaming a narrow RAM window */
+#define EPD_SPI_CHUNK 16
+
+/* RAM buffer images are copied through on their way from flash to SPI */
+#define EPD_IMAGE_CHUNK 128
+
+/** @brief Waveform used to show a new frame */
+enum epd_refresh_mode {
+    EPD_REFRESH_FULL,    /* OTP waveform with flashing, clears ghosting */
+    EPD_REFRESH_FAST,    /* Full-screen waveform, LUT loaded for a forced temperature */
+    EPD_REFRESH_PARTIAL, /* Display mode 2, only changed pixels are driven */
+};
+
+/** @brief RAM planes, as their write commands */
+enum epd_ram {
+    EPD_RAM_BW = 0x24,  /* Image shown by the next refresh */
+    EPD_RAM_OLD = 0x26, /* Previous image, the base of a partial refresh */
+};
+
+/**
+ * @brief Panel-native image for a RAM window
+ *
+ * Rows [ys, ye] of X bytes [xs, xe], already rotated and inverted into
+ * the RAM layout and packed row after row with no padding. Generated by
+ * tools/png_to_epd.py, normally kept in flash.
+ */
+struct epd_image {
+    const uint8_t *data;
+    uint8_t xs;
+    uint8_t xe;
+    uint16_t ys;
+    uint16_t ye;
+};
 
 /**
  * @brief Initialize SPI and GPIO hardware
@@ -17,15 +50,68 @@
 int epd_hardware_init(void);
 
 /**
- * @brief Run the initialization sequence (Waveshare V4 specific)
+ * @brief Run the initialization sequence for the configured panel profile
+ */
+void epd_init_panel(void);
+
+/**
+ * @brief Update a window of the panel and trigger refresh
+ *
+ * Only the window is written to RAM; the rest of RAM must still hold the
+ * frame currently on the panel. The refresh itself covers the whole panel
+ * in the given mode.
+ *
+ * Rows or row bands of the window that are entirely white or black are
+ * filled with the controller's auto-write command instead of being
+ * uploaded. The window is also written to the old-image RAM afterwards, so
+ * it is the base image the next partial update is compared against.
+ *
+ * @param buffer Full frame (EPD_WIDTH_BYTES per row) holding the new content
+ * @param xs First X byte of the window
+ * @param xe Last X byte of the window
+ * @param ys First row of the window
+ * @param ye Last row of the window
+ * @param mode Waveform to use for the refresh
+ */
+void epd_display_window(const uint8_t *buffer, uint8_t xs, uint8_t xe, uint16_t ys, uint16_t ye,
+                        enum epd_refresh_mode mode);
+
+/**
+ * @brief Write a window of one RAM plane without refreshing
+ *
+ * Uniform white or black runs are filled with auto-write as in
+ * epd_display_window(). Used to assemble a frame piecewise before a
+ * single epd_update().
+ *
+ * @param ram Plane to write
+ * @param data Window content, starting at row ys, X byte xs
+ * @param pitch Bytes from one row of data to the next
+ * @param xs First X byte of the window
+ * @param xe Last X byte of the window
+ * @param ys First row of the window
+ * @param ye Last row of the window
+ */
+void epd_write_ram(enum epd_ram ram, const uint8_t *data, size_t pitch, uint8_t xs, uint8_t xe,
+                   uint16_t ys, uint16_t ye);
+
+/**
+ * @brief Refresh the panel from the current RAM contents
+ * @param mode Waveform to use for the refresh
  */
-void epd_init_v4(void);
+void epd_update(enum epd_refresh_mode mode);
 
 /**
- * @brief Send framebuffer to display and trigger refresh
- * @param buffer Pointer to the framebuffer data
- * @param size Size of the buffer in bytes
+ * @brief Show a panel-native image and trigger refresh
+ *
+ * The image is streamed as-is into B/W RAM, and after the refresh into
+ * old-image RAM, with no conversion. SPIM EasyDMA on the nRF52 can only
+ * read RAM, so the data is copied through an EPD_IMAGE_CHUNK-byte buffer
+ * rather than handed to the SPI driver in flash. RAM outside the image
+ * window is left alone.
+ *
+ * @param image Image to show
+ * @param mode Waveform to use for the refresh
  */
-void epd_display_framebuffer(const uint8_t *buffer, size_t size);
+void epd_display_image(const struct epd_image *image, enum epd_refresh_mode mode);
 
 #endif /* EPD_DRIVER_H */
\ No newline at end of file
@@ -4,71 +4,486 @@
 #include <zephyr/device.h>
 #include <zephyr/drivers/display.h>
 #include <zephyr/logging/log.h>
+#include <zephyr/sys/crc.h>
 #include "epd_driver.h"
 #include "epd_graphics.h"
+#include "epd_refresh_policy.h"
 
 LOG_MODULE_REGISTER(epd_graphics, LOG_LEVEL_INF);
 
-/* Logical Landscape Resolution */
-#define LOGICAL_WIDTH  248 /* Multiple of 8, fits in 250 */
-#define LOGICAL_HEIGHT 128
+/* Logical Landscape Resolution, from the panel profile */
+#define LOGICAL_WIDTH  EPD_LOGICAL_WIDTH
+#define LOGICAL_HEIGHT EPD_LOGICAL_HEIGHT
+
+/* Panel pixel holding logical pixel (lx, ly) */
+#if EPD_ROTATE_90
+/* Rotated 90 degrees CW: logical X runs up from the last panel row */
+#define PANEL_X(lx, ly) (ly)
+#define PANEL_Y(lx, ly) ((EPD_HEIGHT - 1) - (lx))
+#else
+#define PANEL_X(lx, ly) (lx)
+#define PANEL_Y(lx, ly) (ly)
+#endif
 
 /* --- Zephyr Display Driver Wrapper --- */
 /* This wrapper allows the CFB subsystem to use our manual EPD driver */
 
+/* While blanked, writes only latch the CFB buffer and do not touch the panel */
+static bool blanked;
+
+/* CFB's own framebuffer, as last handed to custom_epd_write() */
+static uint8_t *cfb_buffer;
+
 static int custom_epd_blanking_off(const struct device *dev)
 {
+	blanked = false;
 	return 0;
 }
 
 static int custom_epd_blanking_on(const struct device *dev)
 {
+	blanked = true;
 	return 0;
 }
 
-static uint8_t rotated_buffer[EPD_WIDTH_BYTES * EPD_HEIGHT];
+uint8_t *epd_graphics_get_framebuffer(const struct device *dev)
+{
+	ARG_UNUSED(dev);
+	return cfb_buffer;
+}
+
+/* --- Refresh policy measure --- */
+
+/* Bands of EPD_BAND_ROWS logical columns, as drawn by display_render_bands() */
+#define BAND_COUNT DIV_ROUND_UP(LOGICAL_WIDTH, EPD_BAND_ROWS)
+
+/* RAM X bytes [xs, xe] and rows [ys, ye] */
+struct ram_window {
+	uint8_t xs;
+	uint8_t xe;
+	uint16_t ys;
+	uint16_t ye;
+};
+
+#if !EPD_ROTATE_90
+BUILD_ASSERT((EPD_BAND_ROWS % 8) == 0, "bands must cover whole RAM X bytes");
+#endif
+
+/* RAM window holding logical columns [x, x + width) */
+static struct ram_window band_window(uint16_t x, uint16_t width)
+{
+#if EPD_ROTATE_90
+	return (struct ram_window){0, EPD_WIDTH_BYTES - 1, EPD_HEIGHT - (x + width),
+				   EPD_HEIGHT - 1 - x};
+#else
+	return (struct ram_window){x / 8, (x + width) / 8 - 1, 0, LOGICAL_HEIGHT - 1};
+#endif
+}
+
+/*
+ * Pixels a changed band counts against the refresh policy. The banded
+ * build keeps no copy of the old content, only its black pixel count, so
+ * the pixels black before or after stand in for the exact difference;
+ * the mirror build counts the same way so a frame weighs the same in
+ * both.
+ */
+static inline uint32_t band_change_bound(uint32_t black_before, uint32_t black_after, size_t size)
+{
+	return MIN(black_before + black_after, size * 8);
+}
+
+#if defined(CONFIG_EPD_BANDED)
+
+/*
+ * What each band of display_render_bands() last left in panel RAM, in
+ * place of a copy of it: a CRC of its RAM bytes and its black pixel
+ * count. Writes that bypass the bands mark them all unknown.
+ *
+ * A band whose new content happens to have the same CRC is not sent, so
+ * on a collision (about one in 2^32 changed bands) the panel keeps the
+ * old band until the band changes again or a forced full refresh resends
+ * every band. Output is the same as an unbanded build's short of that.
+ */
+
+struct band_state {
+	uint32_t crc;
+	uint16_t black;
+	bool valid;
+};
+
+static struct band_state band_state[BAND_COUNT];
+
+static void band_state_invalidate(void)
+{
+	memset(band_state, 0, sizeof(band_state));
+}
+
+/* Frames only arrive in bands; there is no CFB buffer to rotate */
+static int custom_epd_write(const struct device *dev, const uint16_t x, const uint16_t y,
+			    const struct display_buffer_descriptor *desc, const void *buf)
+{
+	return -ENOTSUP;
+}
+
+#else
+
+/*
+ * Panel-native frames: mirror holds what panel RAM holds, next receives
+ * the rows a write covers so the two can be compared to pick a refresh
+ * mode and window. Rows of next outside the current write are stale.
+ */
+static uint8_t mirror[EPD_WIDTH_BYTES * EPD_HEIGHT];
+static uint8_t next[EPD_WIDTH_BYTES * EPD_HEIGHT];
+
+/* Changed pixels between two panel frames and the RAM window enclosing them */
+struct frame_diff {
+	uint32_t changed;
+	uint8_t xs;
+	uint8_t xe;
+	uint16_t ys;
+	uint16_t ye;
+};
+
+/* Compare rows first..last of two panel frames */
+static void diff_frames(const uint8_t *a, const uint8_t *b, int first, int last,
+			struct frame_diff *diff)
+{
+	*diff = (struct frame_diff){.xs = EPD_WIDTH_BYTES - 1, .ys = EPD_HEIGHT - 1};
+
+	for (int row = first; row <= last; row++) {
+		for (int xb = 0; xb < EPD_WIDTH_BYTES; xb++) {
+			uint8_t d = a[row * EPD_WIDTH_BYTES + xb] ^ b[row * EPD_WIDTH_BYTES + xb];
+
+			if (d == 0) {
+				continue;
+			}
+			diff->changed += __builtin_popcount(d);
+			diff->xs = MIN(diff->xs, xb);
+			diff->xe = MAX(diff->xe, xb);
+			diff->ys = MIN(diff->ys, row);
+			diff->ye = row;
+		}
+	}
+}
+
+/* Black pixels of a panel frame inside a RAM window */
+static uint32_t window_black(const uint8_t *frame, const struct ram_window *win)
+{
+	uint32_t black = 0;
+
+	for (int row = win->ys; row <= win->ye; row++) {
+		for (int xb = win->xs; xb <= win->xe; xb++) {
+			black += 8 - __builtin_popcount(frame[row * EPD_WIDTH_BYTES + xb]);
+		}
+	}
+	return black;
+}
+
+static bool window_differs(const uint8_t *a, const uint8_t *b, const struct ram_window *win)
+{
+	for (int row = win->ys; row <= win->ye; row++) {
+		const size_t at = row * EPD_WIDTH_BYTES + win->xs;
+
+		if (memcmp(&a[at], &b[at], win->xe - win->xs + 1) != 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/*
+ * Refresh policy measure of a write to logical columns [x0, x1] that
+ * replaced panel rows [r0, r1] of the mirror with next: band_change_bound()
+ * summed over the bands that changed, as the banded build counts them.
+ */
+static uint32_t frame_change_bound(int x0, int x1, int r0, int r1)
+{
+	uint32_t changed = 0;
 
+	for (int x = x0 - x0 % EPD_BAND_ROWS; x <= x1; x += EPD_BAND_ROWS) {
+		const struct ram_window win = band_window(x, MIN(EPD_BAND_ROWS, LOGICAL_WIDTH - x));
+		/* Rows outside [r0, r1] are the same in both frames */
+		const struct ram_window written = {win.xs, win.xe, MAX(win.ys, r0), MIN(win.ye, r1)};
+		const size_t size = (win.xe - win.xs + 1) * (win.ye - win.ys + 1);
+
+		if (!window_differs(mirror, next, &written)) {
+			continue;
+		}
+
+		uint32_t before = window_black(mirror, &win);
+		uint32_t after = before - window_black(mirror, &written) + window_black(next, &written);
+
+		changed += band_change_bound(before, after, size);
+	}
+	return changed;
+}
+
+/*
+ * Accepts the whole frame or any sub-area whose y is a multiple of 8 (a
+ * whole MONO10 page); the buffer then holds only that area, pitch bytes
+ * per page. Only the panel rows under the area are converted and compared,
+ * and only RAM covering pixels that actually changed is rewritten. A whole
+ * frame gets whatever refresh the policy picks; a sub-area is a partial
+ * update unless the policy's ghosting limits force a full refresh.
+ */
 static int custom_epd_write(const struct device *dev, const uint16_t x, const uint16_t y,
 			    const struct display_buffer_descriptor *desc, const void *buf)
 {
 	const uint8_t *src = buf;
-	uint8_t *dst = rotated_buffer;
-	
-	/* Clear destination buffer */
-	memset(dst, 0, sizeof(rotated_buffer));
+	const bool whole = x == 0 && y == 0 && desc->width == LOGICAL_WIDTH &&
+			   desc->height == LOGICAL_HEIGHT;
+	struct frame_diff diff;
+
+	if (whole) {
+		/* CFB always passes its heap buffer, valid until cfb_framebuffer_deinit() */
+		cfb_buffer = (uint8_t *)buf;
+	}
+	if (blanked) {
+		return 0;
+	}
+	if ((y % 8) != 0 || x + desc->width > LOGICAL_WIDTH || y + desc->height > LOGICAL_HEIGHT) {
+		return -EINVAL;
+	}
+	if (desc->width == 0 || desc->height == 0) {
+		return 0;
+	}
+
+	/* Panel rows under the area; the corners map to the first and last */
+	const int r0 = MIN(PANEL_Y(x, y), PANEL_Y(x + desc->width - 1, y + desc->height - 1));
+	const int r1 = MAX(PANEL_Y(x, y), PANEL_Y(x + desc->width - 1, y + desc->height - 1));
+	const size_t rows = (r1 - r0 + 1) * EPD_WIDTH_BYTES;
+
+	/* Start from the frame on the panel so pixels outside the area are kept */
+	memcpy(&next[r0 * EPD_WIDTH_BYTES], &mirror[r0 * EPD_WIDTH_BYTES], rows);
 
 	/*
-	 * Rotate 90 degrees CW
-	 * Logical (Landscape) -> Physical (Portrait)
-	 * Logical X [0..247] -> Physical Y [249..2]
-	 * Logical Y [0..127] -> Physical X [0..127]
+	 * Logical (Landscape) -> Physical, see PANEL_X/PANEL_Y. On portrait
+	 * panels logical X [0..W-1] is physical Y [H-1..H-W] and logical Y is
+	 * physical X.
 	 *
 	 * Source buffer is MONO10 (vertical tiled, MSB first).
 	 */
-	for (int ly = 0; ly < LOGICAL_HEIGHT; ly++) {
-		for (int lx = 0; lx < LOGICAL_WIDTH; lx++) {
+	for (int ly = 0; ly < desc->height; ly++) {
+		for (int lx = 0; lx < desc->width; lx++) {
 			/* Get pixel from Source (Logical), vertical tiled */
-			size_t src_index = (ly / 8) * LOGICAL_WIDTH + lx;
-			uint8_t src_byte = src[src_index];
+			uint8_t src_byte = src[(ly / 8) * desc->pitch + lx];
+
+			/* Map to Destination (Physical) */
+			int px = PANEL_X(x + lx, y + ly);
+			int py = PANEL_Y(x + lx, y + ly);
+			uint8_t *d = &next[(py * EPD_WIDTH_BYTES) + (px / 8)];
+			uint8_t bit = 0x80 >> (px % 8);
+
+			/* Panel polarity is inverted vs CFB: set pixels are cleared bits */
 			if (src_byte & (0x80 >> (ly % 8))) {
-				/* Map to Destination (Physical) */
-				int px = ly;
-				int py = (EPD_HEIGHT - 1) - lx;
+				*d &= ~bit;
+			} else {
+				*d |= bit;
+			}
+		}
+	}
+
+	diff_frames(next, mirror, r0, r1, &diff);
+	if (diff.changed == 0) {
+		if (!epd_refresh_policy_full_pending()) {
+			return 0;
+		}
+		/* A forced full refresh redraws the panel, so send the whole of next */
+		memcpy(next, mirror, r0 * EPD_WIDTH_BYTES);
+		memcpy(&next[(r1 + 1) * EPD_WIDTH_BYTES], &mirror[(r1 + 1) * EPD_WIDTH_BYTES],
+		       sizeof(next) - (r1 + 1) * EPD_WIDTH_BYTES);
+		diff = (struct frame_diff){.xe = EPD_WIDTH_BYTES - 1, .ye = EPD_HEIGHT - 1};
+	}
+
+	/* The policy weighs the frame as the banded build would, not by diff.changed */
+	const uint32_t changed = frame_change_bound(x, x + desc->width - 1, r0, r1);
+
+	epd_display_window(next, diff.xs, diff.xe, diff.ys, diff.ye,
+			   whole ? epd_refresh_policy_select(changed)
+				 : epd_refresh_policy_select_partial(changed));
+	memcpy(&mirror[r0 * EPD_WIDTH_BYTES], &next[r0 * EPD_WIDTH_BYTES], rows);
+	return 0;
+}
+
+#endif /* CONFIG_EPD_BANDED */
+
+int epd_graphics_show_image(const struct device *dev, const struct epd_image *image)
+{
+	const int width = image->xe - image->xs + 1;
+
+	ARG_UNUSED(dev);
+
+	if (image->xs > image->xe || image->xe >= EPD_WIDTH_BYTES || image->ys > image->ye ||
+	    image->ye >= EPD_HEIGHT) {
+		return -EINVAL;
+	}
+
+#if defined(CONFIG_EPD_BANDED)
+	/* Nothing records what the panel shows, so assume the whole window changes */
+	uint32_t changed = width * 8 * (image->ye - image->ys + 1);
+#else
+	uint32_t changed = 0;
+
+	for (int row = image->ys; row <= image->ye; row++) {
+		const uint8_t *on_panel = &mirror[row * EPD_WIDTH_BYTES + image->xs];
+		const uint8_t *data = &image->data[(row - image->ys) * width];
+
+		for (int xb = 0; xb < width; xb++) {
+			changed += __builtin_popcount(on_panel[xb] ^ data[xb]);
+		}
+	}
+	if (changed == 0 && !epd_refresh_policy_full_pending()) {
+		return 0;
+	}
+#endif
+
+	epd_display_image(image, epd_refresh_policy_select(changed));
+
+#if defined(CONFIG_EPD_BANDED)
+	band_state_invalidate();
+#else
+	/* Keep the mirror of panel RAM in step so the next diff is exact */
+	for (int row = image->ys; row <= image->ye; row++) {
+		memcpy(&mirror[row * EPD_WIDTH_BYTES + image->xs],
+		       &image->data[(row - image->ys) * width], width);
+	}
+#endif
+	return 0;
+}
+
+#if defined(CONFIG_EPD_BANDED)
+
+/* --- Band output --- */
+
+BUILD_ASSERT(BAND_COUNT <= 32, "band flags are 32-bit");
+BUILD_ASSERT(EPD_BAND_ROWS * LOGICAL_HEIGHT <= UINT16_MAX, "black pixel counts are 16-bit");
+
+/* One band in panel layout, as streamed to RAM */
+static uint8_t band_rows[EPD_BAND_ROWS * (LOGICAL_HEIGHT / 8)];
+
+#if EPD_ROTATE_90
+/*
+ * Logical column lx is panel row H - 1 - lx, and its MONO10 pages are
+ * already that row's bytes in order: rotating is a gather plus the
+ * polarity inversion.
+ */
+static void band_to_panel(const uint8_t *buf, uint16_t width)
+{
+	for (int i = 0; i < width; i++) {
+		uint8_t *row = &band_rows[(width - 1 - i) * EPD_WIDTH_BYTES];
+
+		for (int page = 0; page < EPD_WIDTH_BYTES; page++) {
+			row[page] = ~buf[page * width + i];
+		}
+	}
+}
+#else
+/* Same orientation: transpose 8x8 blocks of vertical bytes into row bytes */
+static void band_to_panel(const uint8_t *buf, uint16_t width)
+{
+	const int pitch = width / 8;
+
+	for (int page = 0; page < LOGICAL_HEIGHT / 8; page++) {
+		for (int xb = 0; xb < pitch; xb++) {
+			const uint8_t *col = &buf[page * width + xb * 8];
 
-				dst[(py * EPD_WIDTH_BYTES) + (px / 8)] |= (0x80 >> (px % 8));
+			for (int r = 0; r < 8; r++) {
+				uint8_t v = 0;
+
+				for (int c = 0; c < 8; c++) {
+					v |= (uint8_t)(col[c] << r & 0x80) >> c;
+				}
+				band_rows[(page * 8 + r) * pitch + xb] = ~v;
 			}
 		}
 	}
+}
+#endif
 
-	/* Panel polarity is inverted vs CFB: flip bits to get white background. */
-	for (size_t i = 0; i < sizeof(rotated_buffer); i++) {
-		dst[i] ^= 0xFF;
+static struct {
+	uint32_t changed_bands;
+	uint32_t changed_pixels;
+	/* Refresh done: writes now go to old-image RAM */
+	bool updated;
+} band;
+
+void epd_graphics_band_begin(const struct device *dev)
+{
+	ARG_UNUSED(dev);
+	memset(&band, 0, sizeof(band));
+
+	/* A forced full refresh redraws the panel anyway: resend every band */
+	if (epd_refresh_policy_full_pending()) {
+		band_state_invalidate();
 	}
+}
+
+int epd_graphics_band_write(const struct device *dev, uint16_t x, uint16_t width, const uint8_t *buf)
+{
+	ARG_UNUSED(dev);
+
+	if ((x % EPD_BAND_ROWS) != 0 || width == 0 || width > EPD_BAND_ROWS ||
+	    x + width > LOGICAL_WIDTH) {
+		return -EINVAL;
+	}
+
+	const struct ram_window win = band_window(x, width);
+	const uint8_t xs = win.xs;
+	const uint8_t xe = win.xe;
+	const uint16_t ys = win.ys;
+	const uint16_t ye = win.ye;
+	const size_t pitch = xe - xs + 1;
+
+	band_to_panel(buf, width);
+
+	if (band.updated) {
+		epd_write_ram(EPD_RAM_OLD, band_rows, pitch, xs, xe, ys, ye);
+		return 0;
+	}
+
+	/* Both RAM planes hold the last frame: a band with the same CRC needs no transfer */
+	struct band_state *state = &band_state[x / EPD_BAND_ROWS];
+	const size_t size = pitch * (ye - ys + 1);
+	const uint32_t crc = crc32_ieee(band_rows, size);
+	uint16_t black = size * 8;
 
-	epd_display_framebuffer(rotated_buffer, sizeof(rotated_buffer));
+	if (state->valid && state->crc == crc) {
+		return 0;
+	}
+	for (size_t i = 0; i < size; i++) {
+		black -= __builtin_popcount(band_rows[i]);
+	}
+
+	epd_write_ram(EPD_RAM_BW, band_rows, pitch, xs, xe, ys, ye);
+
+	/* A band nothing is known about may have changed entirely */
+	band.changed_pixels += state->valid ? band_change_bound(state->black, black, size) : size * 8;
+	band.changed_bands |= BIT(x / EPD_BAND_ROWS);
+	*state = (struct band_state){.crc = crc, .black = black, .valid = true};
+	return 0;
+}
+
+int epd_graphics_band_update(const struct device *dev)
+{
+	ARG_UNUSED(dev);
+
+	band.updated = true;
+	if (band.changed_pixels == 0 && !epd_refresh_policy_full_pending()) {
+		return 0;
+	}
+
+	epd_update(epd_refresh_policy_select(band.changed_pixels));
 	return 0;
 }
 
+bool epd_graphics_band_changed(const struct device *dev, uint16_t x)
+{
+	ARG_UNUSED(dev);
+	return (band.changed_bands & BIT(x / EPD_BAND_ROWS)) != 0;
+}
+
+#endif /* CONFIG_EPD_BANDED */
+
 static int custom_epd_read(const struct device *dev, const uint16_t x, const uint16_t y,
 			   const struct display_buffer_descriptor *desc, void *buf)
 {
@@ -114,8 +529,14 @@ static int custom_epd_init(const struct device *dev)
 		return err;
 	}
 
-	/* Run the specific V4 initialization sequence */
-	epd_init_v4();
+	/* Run the initialization sequence of the configured panel */
+	epd_init_panel();
+
+#if !defined(CONFIG_EPD_BANDED)
+	/* Panel RAM starts out white */
+	memset(mirror, 0xFF, sizeof(mirror));
+#endif
+	epd_refresh_policy_init(NULL);
 
 	return 0;
 }
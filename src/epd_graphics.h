@@ -2,6 +2,95 @@
 #ifndef EPD_GRAPHICS_H
 #define EPD_GRAPHICS_H
 
+#include <zephyr/device.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "epd_driver.h"
+
 #define CUSTOM_EPD_LABEL "CUSTOM_EPD"
 
+/* Logical columns per band for display_render_bands(), panel rows when rotated */
+#ifndef EPD_BAND_ROWS
+#define EPD_BAND_ROWS 32
+#endif
+
+/**
+ * @brief Get the CFB framebuffer last written to the driver
+ *
+ * The buffer is in the CFB layout (MONO10, vertical tiled, MSB first) and
+ * can be drawn into directly; changes reach the panel on the next
+ * cfb_framebuffer_finalize().
+ *
+ * @param dev Display device instance
+ * @return Pointer to the framebuffer, or NULL if CFB has not written yet
+ */
+uint8_t *epd_graphics_get_framebuffer(const struct device *dev);
+
+/**
+ * @brief Show a pre-formatted image, bypassing CFB
+ *
+ * The image goes from flash to the panel unconverted, through a small RAM
+ * chunk buffer since SPI DMA cannot read flash. The refresh policy
+ * is given the number of pixels that differ from what the panel shows, and
+ * an image identical to it is not sent at all; with CONFIG_EPD_BANDED,
+ * where nothing records the panel contents, every pixel in the window
+ * counts as changed. CFB's buffer is not updated, so the next
+ * cfb_framebuffer_finalize() redraws whatever differs from the image.
+ *
+ * @param dev Display device instance
+ * @param image Image generated by tools/png_to_epd.py
+ * @return 0 on success, -EINVAL if the window is outside the panel
+ */
+int epd_graphics_show_image(const struct device *dev, const struct epd_image *image);
+
+#if defined(CONFIG_EPD_BANDED)
+
+/**
+ * @brief Start a frame sent band by band
+ *
+ * A banded frame is written in two passes of epd_graphics_band_write():
+ * every band into B/W RAM, then epd_graphics_band_update(), then the bands
+ * reported by epd_graphics_band_changed() again into old-image RAM. Bands
+ * are compared by CRC with what the previous banded frame left there, not
+ * by content, so a band whose new content collides with the old CRC stays
+ * stale until it changes again; a forced full refresh resends every band.
+ * Anything written to the panel outside bands makes every band count as
+ * changed.
+ *
+ * @param dev Display device instance
+ */
+void epd_graphics_band_begin(const struct device *dev);
+
+/**
+ * @brief Rotate one band and write it to panel RAM
+ *
+ * @param dev Display device instance
+ * @param x First logical column, a multiple of EPD_BAND_ROWS
+ * @param width Logical columns in the band, at most EPD_BAND_ROWS
+ * @param buf Band in the CFB layout (MONO10, full height, width bytes per page)
+ * @return 0 on success, -EINVAL if the band is misplaced
+ */
+int epd_graphics_band_write(const struct device *dev, uint16_t x, uint16_t width, const uint8_t *buf);
+
+/**
+ * @brief Refresh the panel after the first pass of a banded frame
+ *
+ * Nothing is refreshed if no band changed, unless the refresh policy has
+ * a full refresh pending.
+ *
+ * @param dev Display device instance
+ * @return 0 on success
+ */
+int epd_graphics_band_update(const struct device *dev);
+
+/**
+ * @brief Check whether a band must be written again to old-image RAM
+ * @param dev Display device instance
+ * @param x First logical column of the band
+ * @return true if the band differed from the panel
+ */
+bool epd_graphics_band_changed(const struct device *dev, uint16_t x);
+
+#endif /* CONFIG_EPD_BANDED */
+
 #endif /* EPD_GRAPHICS_H */
\ No newline at end of file
@@ -0,0 +1,105 @@
+/* src/epd_panel.h */
+#ifndef EPD_PANEL_H
+#define EPD_PANEL_H
+
+/*
+ * Panel profiles, one per CONFIG_EPD_PANEL_* choice (see Kconfig). All
+ * values are compile-time constants, so loops and buffers throughout the
+ * driver are specialised for the selected panel.
+ *
+ * EPD_WIDTH, EPD_HEIGHT  RAM size in native pixels: source lines (a
+ *                        multiple of 8) by gate lines
+ * EPD_ROTATE_90          1 if the panel is natively portrait and frames
+ *                        are rotated into landscape
+ * EPD_SOFT_START         Booster soft-start bytes (0x0C), if required
+ * EPD_UPDATE_CTRL1       Display update control 1 bytes (0x21), if not
+ *                        the reset default
+ * EPD_BORDER_WAVEFORM    Border waveform (0x3C) for full and fast updates
+ * EPD_FAST_TEMPERATURE   Temperature forced to load the fast LUT
+ * EPD_PARTIAL_CTRL1      Display update control 1 bytes for partial
+ *                        updates, if they differ from EPD_UPDATE_CTRL1
+ *                        (which must then be defined too)
+ * EPD_PARTIAL_LUT        Partial update waveform sent by the host, if the
+ *                        OTP one is unusable: 153 LUT bytes (0x32), then
+ *                        EOPT (0x3F), gate voltage (0x03), source voltages
+ *                        (0x04, 3 bytes) and VCOM (0x2C)
+ * EPD_PARTIAL_OPTION     Display option bytes (0x37, 10 bytes) written
+ *                        with EPD_PARTIAL_LUT
+ */
+
+#if defined(CONFIG_EPD_PANEL_WS_29_V2)
+
+/* Waveshare 2.9" V2, SSD1680 */
+#define EPD_WIDTH            128
+#define EPD_HEIGHT           296
+#define EPD_ROTATE_90        1
+#define EPD_UPDATE_CTRL1     {0x00, 0x80}
+#define EPD_BORDER_WAVEFORM  0x05
+#define EPD_FAST_TEMPERATURE 0x64
+/* Partial updates use the waveform from Waveshare's driver, loaded by the host */
+#define EPD_PARTIAL_LUT                                                                    \
+	{                                                                                  \
+		0x00, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,    \
+		0x80, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,    \
+		0x40, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,    \
+		0x00, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,    \
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,    \
+		0x0A, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02,                                  \
+		0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,                                  \
+		0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,                                  \
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,                                  \
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,                                  \
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,                                  \
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,                                  \
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,                                  \
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,                                  \
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,                                  \
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,                                  \
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,                                  \
+		0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x00, 0x00, 0x00,                      \
+		0x22, 0x17, 0x41, 0xB0, 0x32, 0x36,                                        \
+	}
+/*
+ * Waveshare's display option with RAM ping-pong (byte 6, 0x40) cleared.
+ * Ping-pong swaps the RAM planes after each partial update, which suits
+ * rewriting the whole frame into B/W RAM every time; this driver instead
+ * writes only changed windows, to both planes, so the planes must not move.
+ */
+#define EPD_PARTIAL_OPTION {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}
+
+#elif defined(CONFIG_EPD_PANEL_WS_42_V2)
+
+/* Waveshare 4.2" V2, SSD1683, natively landscape */
+#define EPD_WIDTH            400
+#define EPD_HEIGHT           300
+#define EPD_ROTATE_90        0
+#define EPD_UPDATE_CTRL1     {0x40, 0x00}
+#define EPD_BORDER_WAVEFORM  0x05
+#define EPD_FAST_TEMPERATURE 0x6E
+/* Display mode 2 compares with the old-image RAM, so it must not read as 0 */
+#define EPD_PARTIAL_CTRL1    {0x00, 0x00}
+
+#else
+
+/* Waveshare 2.13" V4, SSD1680, 122 visible source lines */
+#define EPD_WIDTH            128
+#define EPD_HEIGHT           250
+#define EPD_ROTATE_90        1
+#define EPD_SOFT_START       {0xAE, 0xC7, 0xC3, 0xC0, 0x80}
+#define EPD_BORDER_WAVEFORM  0x05
+#define EPD_FAST_TEMPERATURE 0x64
+
+#endif
+
+#define EPD_WIDTH_BYTES (EPD_WIDTH / 8)
+
+/* Landscape frame seen by CFB; its height is a whole number of MONO10 pages */
+#if EPD_ROTATE_90
+#define EPD_LOGICAL_WIDTH  (EPD_HEIGHT & ~7)
+#define EPD_LOGICAL_HEIGHT EPD_WIDTH
+#else
+#define EPD_LOGICAL_WIDTH  EPD_WIDTH
+#define EPD_LOGICAL_HEIGHT (EPD_HEIGHT & ~7)
+#endif
+
+#endif /* EPD_PANEL_H */
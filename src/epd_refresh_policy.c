@@ -0,0 +1,99 @@
+/* src/epd_refresh_policy.c */
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include "epd_refresh_policy.h"
+
+LOG_MODULE_REGISTER(epd_refresh_policy, LOG_LEVEL_INF);
+
+#define EPD_PIXELS ((uint32_t)EPD_WIDTH * EPD_HEIGHT)
+
+static struct epd_refresh_policy_config config = {
+	.max_partials = EPD_REFRESH_POLICY_MAX_PARTIALS,
+	.max_area = EPD_REFRESH_POLICY_MAX_AREA,
+	.max_age_ms = EPD_REFRESH_POLICY_MAX_AGE_MS,
+	.fast_percent = EPD_REFRESH_POLICY_FAST_PERCENT,
+};
+
+static struct epd_refresh_stats stats;
+static int64_t last_full_ms;
+
+/* The panel content is unknown until the first full refresh */
+static bool full_pending = true;
+
+void epd_refresh_policy_init(const struct epd_refresh_policy_config *cfg)
+{
+	if (cfg != NULL) {
+		config = *cfg;
+	}
+
+	stats = (struct epd_refresh_stats){0};
+	full_pending = true;
+}
+
+static enum epd_refresh_mode select_mode(uint32_t changed_pixels, bool allow_fast)
+{
+	int64_t now = k_uptime_get();
+	enum epd_refresh_mode mode;
+
+	if (full_pending ||
+	    (now - last_full_ms) >= config.max_age_ms ||
+	    stats.partials_pending >= config.max_partials ||
+	    stats.area_pending + changed_pixels > config.max_area) {
+		mode = EPD_REFRESH_FULL;
+	} else if (allow_fast &&
+		   (uint64_t)changed_pixels * 100U >= (uint64_t)config.fast_percent * EPD_PIXELS) {
+		/* Most of the screen changes anyway, so redraw it all without flashing */
+		mode = EPD_REFRESH_FAST;
+	} else {
+		mode = EPD_REFRESH_PARTIAL;
+	}
+
+	switch (mode) {
+	case EPD_REFRESH_FULL:
+		stats.full++;
+		last_full_ms = now;
+		full_pending = false;
+		stats.partials_pending = 0;
+		stats.area_pending = 0;
+		break;
+	case EPD_REFRESH_FAST:
+		/* Drives every pixel, which clears partial-update residue */
+		stats.fast++;
+		stats.partials_pending = 0;
+		stats.area_pending = 0;
+		break;
+	default:
+		stats.partial++;
+		stats.partials_pending++;
+		stats.area_pending += changed_pixels;
+		break;
+	}
+
+	LOG_DBG("%u pixels changed -> mode %d", changed_pixels, mode);
+	return mode;
+}
+
+enum epd_refresh_mode epd_refresh_policy_select(uint32_t changed_pixels)
+{
+	return select_mode(changed_pixels, true);
+}
+
+enum epd_refresh_mode epd_refresh_policy_select_partial(uint32_t changed_pixels)
+{
+	return select_mode(changed_pixels, false);
+}
+
+void epd_refresh_policy_force_full(void)
+{
+	full_pending = true;
+}
+
+bool epd_refresh_policy_full_pending(void)
+{
+	return full_pending;
+}
+
+void epd_refresh_policy_get_stats(struct epd_refresh_stats *out)
+{
+	*out = stats;
+}
@@ -0,0 +1,89 @@
+/* src/epd_refresh_policy.h */
+#ifndef EPD_REFRESH_POLICY_H
+#define EPD_REFRESH_POLICY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "epd_driver.h"
+
+/* Defaults used when epd_refresh_policy_init() is given no configuration */
+#define EPD_REFRESH_POLICY_MAX_PARTIALS   20
+#define EPD_REFRESH_POLICY_MAX_AREA       (2U * EPD_WIDTH * EPD_HEIGHT)
+#define EPD_REFRESH_POLICY_MAX_AGE_MS     (4U * 60U * 60U * 1000U)
+#define EPD_REFRESH_POLICY_FAST_PERCENT   40
+
+/** @brief Limits that bound ghosting between full refreshes */
+struct epd_refresh_policy_config {
+	/** Partial updates allowed before a full refresh is forced */
+	uint16_t max_partials;
+	/** Changed pixels accumulated over partial updates before a full refresh */
+	uint32_t max_area;
+	/** Time since the last full refresh after which the next one is full */
+	uint32_t max_age_ms;
+	/** Frames changing at least this share of pixels use the fast waveform */
+	uint8_t fast_percent;
+};
+
+/** @brief How often each refresh mode was chosen */
+struct epd_refresh_stats {
+	uint32_t full;
+	uint32_t fast;
+	uint32_t partial;
+	/** Partial updates since the last full or fast refresh */
+	uint16_t partials_pending;
+	/** Changed pixels accumulated since the last full or fast refresh */
+	uint32_t area_pending;
+};
+
+/**
+ * @brief Configure the policy and reset its state
+ *
+ * The first frame after this call is always a full refresh.
+ *
+ * @param cfg Limits to use, or NULL for the defaults above
+ */
+void epd_refresh_policy_init(const struct epd_refresh_policy_config *cfg);
+
+/**
+ * @brief Choose the refresh mode for the next frame and account for it
+ *
+ * epd_graphics passes an upper bound rather than the exact count: for each
+ * band of EPD_BAND_ROWS logical columns that changed, the pixels black
+ * before plus those black after, which is all the banded build can know.
+ *
+ * @param changed_pixels Number of pixels that differ from the frame on the panel
+ * @return Refresh mode to pass to the driver
+ */
+enum epd_refresh_mode epd_refresh_policy_select(uint32_t changed_pixels);
+
+/**
+ * @brief Choose the refresh mode for an update of part of the screen
+ *
+ * Like epd_refresh_policy_select(), but the fast waveform is never used:
+ * the update is partial unless a ghosting limit forces a full refresh.
+ *
+ * @param changed_pixels Number of pixels that differ from the frame on the panel
+ * @return Refresh mode to pass to the driver
+ */
+enum epd_refresh_mode epd_refresh_policy_select_partial(uint32_t changed_pixels);
+
+/**
+ * @brief Make the next frame a full refresh regardless of the limits
+ */
+void epd_refresh_policy_force_full(void);
+
+/**
+ * @brief Check whether the next frame has to be a full refresh
+ *
+ * True before the first frame and after epd_refresh_policy_force_full();
+ * such a frame must be shown even if nothing changed.
+ */
+bool epd_refresh_policy_full_pending(void);
+
+/**
+ * @brief Get refresh statistics
+ * @param stats Destination for the counters
+ */
+void epd_refresh_policy_get_stats(struct epd_refresh_stats *stats);
+
+#endif /* EPD_REFRESH_POLICY_H */
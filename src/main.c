@@ -1,16 +1,35 @@
 #include <zephyr/kernel.h>
 #include <zephyr/device.h>
 #include <zephyr/logging/log.h>
+#include <zephyr/drivers/display.h>
 #include <zephyr/display/cfb.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "epd_graphics.h"
 #include "display_lib.h"
+#include "epd_refresh_policy.h"
+#ifdef FONT_PACK
+#include "font_pack.h"
+#endif
 
 LOG_MODULE_REGISTER(main, LOG_LEVEL_DBG);
 
 /* --- Main Application --- */
 
+struct clock_frame {
+	const char *text;
+	uint16_t x;
+	uint16_t y;
+};
+
+static void draw_clock(const struct device *dev, void *user_data)
+{
+	const struct clock_frame *frame = user_data;
+
+	display_draw_text(dev, frame->text, frame->x, frame->y, DISPLAY_ROP_OR, NULL);
+}
+
 int main(void)
 {
 	const struct device *dev = device_get_binding(CUSTOM_EPD_LABEL);
@@ -23,30 +42,39 @@ int main(void)
 
 	LOG_INF("Drawing text with CFB...");
 
-	int font_count = cfb_get_numof_fonts(dev);
 	int best_idx = -1;
 	uint8_t best_w = 0;
 	uint8_t best_h = 0;
-
-	for (int i = 0; i < font_count; i++) {
-		uint8_t fw = 0;
-		uint8_t fh = 0;
-
-		if (cfb_get_font_size(dev, i, &fw, &fh) == 0) {
-			if (fh > best_h) {
-				best_idx = i;
-				best_w = fw;
-				best_h = fh;
-			}
+	uint8_t fw = 0;
+	uint8_t fh = 0;
+
+	for (int i = 0; display_get_font_size(dev, i, &fw, &fh) == 0; i++) {
+		if (fh > best_h) {
+			best_idx = i;
+			best_w = fw;
+			best_h = fh;
 		}
 	}
 
-	if (best_idx < 0 || display_set_font(dev, best_idx) != 0) {
-		LOG_WRN("No usable CFB fonts found");
+#ifdef FONT_PACK
+	/* Clock digits from fonts/font_pack.json replace the CFB font */
+	if (display_set_pack_font(dev, &font_pack_lato_bold_60) == 0) {
+		best_w = font_pack_lato_bold_60.width;
+		best_h = font_pack_lato_bold_60.height;
+		LOG_INF("Using font pack font lato_bold_60 (%ux%u)", best_w, best_h);
+	} else
+#endif
+	if (best_idx >= 0 && display_set_font(dev, best_idx) == 0) {
+		LOG_INF("Using font index %d (%ux%u)", best_idx, best_w, best_h);
+	} else {
+		/* CONFIG_EPD_BANDED without CFB has only font pack fonts */
+		LOG_WRN("No usable fonts found");
 		return 0;
 	}
 
-	LOG_INF("Using font index %d (%ux%u)", best_idx, best_w, best_h);
+	struct display_capabilities caps;
+
+	display_get_capabilities(dev, &caps);
 
 	// int seconds = (12 * 3600) + (34 * 60);
 	int seconds = 0;
@@ -58,10 +86,26 @@ int main(void)
 
 		snprintf(time_str, sizeof(time_str), "%02d:%02d", hours, minutes);
 
+		/* Centre on the screen; glyphs may start at any pixel row */
+		int text_w = (int)strlen(time_str) * best_w;
+		int x = (caps.x_resolution - text_w) / 2;
+		int y = (caps.y_resolution - best_h) / 2;
+		/* Text larger than the screen starts at the edge and is clipped */
+		struct clock_frame frame = {time_str, MAX(x, 0), MAX(y, 0)};
+
+#if defined(CONFIG_EPD_BANDED)
+		display_render_bands(dev, draw_clock, &frame);
+#else
 		cfb_framebuffer_clear(dev, false);
-		/* Align to 8-pixel boundary to avoid partial glyph clipping */
-		display_print(dev, time_str, 50, 40);
+		draw_clock(dev, &frame);
 		display_flush(dev);
+#endif
+
+		struct epd_refresh_stats stats;
+
+		epd_refresh_policy_get_stats(&stats);
+		LOG_INF("Refreshes: %u full, %u fast, %u partial", stats.full, stats.fast,
+			stats.partial);
 
 		seconds += duration_in_seconds;
 		k_sleep(K_SECONDS(duration_in_seconds));
@@ -0,0 +1,276 @@
+#!/usr/bin/env python3
+"""
+Generate a font pack holding only the glyphs an application actually uses.
+
+Usage:
+  python3 tools/gen_font_pack.py --manifest fonts/font_pack.json --out-dir build/font_pack
+example (normally run by the build, see CMakeLists.txt):
+  west build -b nrf52840dk_nrf52840 -- -DFONT_PACK_MANIFEST=fonts/font_pack.json
+
+Manifest (JSON, paths relative to the manifest):
+  {
+    "fonts": [
+      {
+        "name": "lato_bold",                  # C identifier prefix
+        "font": "Lato-Bold.ttf",              # TTF/OTF file
+        "sizes": [60],                        # point sizes, one font each
+        "chars": "0123456789:",               # characters always included
+        "sources": ["ui_strings.json"]        # string tables or sources to scan
+      }
+    ]
+  }
+
+Sources ending in .c/.h/.cpp/.hpp contribute the characters of their string
+literals (printf conversions such as %02d are skipped; list the characters
+they produce under "chars"). .json sources contribute every string value,
+any other file every line, so plain string tables work as-is. Scanning a
+C file also picks up its log and assert messages, so point "sources" at
+the files holding user-visible text rather than at application code.
+
+Every (font, size) pair becomes one fixed-cell `struct display_font`
+(see src/display_lib.h). Glyph bitmaps are vertically packed, MSB on top,
+and identical bitmaps are stored once in a pool shared by the whole pack.
+
+Requirements:
+  - PIL/Pillow (python3 -m pip install pillow)
+
+Outputs:
+  - <out-dir>/font_pack.c
+  - <out-dir>/font_pack.h
+  - <depfile> listing the manifest, fonts and sources (optional)
+"""
+
+import argparse
+import json
+import math
+import os
+import re
+
+from PIL import Image
+from PIL import ImageDraw
+from PIL import ImageFont
+
+
+C_EXTENSIONS = (".c", ".h", ".cpp", ".hpp")
+
+C_TOKEN = re.compile(
+    r'//[^\n]*|/\*.*?\*/|^\s*#\s*include[^\n]*|"((?:[^"\\\n]|\\.)*)"|\'(?:[^\'\\\n]|\\.)*\'',
+    re.DOTALL | re.MULTILINE,
+)
+C_ESCAPE = re.compile(r'\\(x[0-9A-Fa-f]+|[0-7]{1,3}|.)', re.DOTALL)
+PRINTF_CONVERSION = re.compile(r"%[-+ #0]*(\*|\d+)?(\.(\*|\d+))?[hlLqjzt]*[diouxXeEfFgGaAcspn%]")
+SIMPLE_ESCAPES = {"n": "\n", "t": "\t", "r": "\r", "0": "\0", "a": "\a", "b": "\b",
+                  "f": "\f", "v": "\v"}
+
+
+def parse_args() -> argparse.Namespace:
+    parser = argparse.ArgumentParser(
+        description="Generate a subsetted, deduplicated font pack from a manifest."
+    )
+    parser.add_argument(
+        "--manifest",
+        required=True,
+        help="Path to the font pack manifest (JSON)",
+    )
+    parser.add_argument(
+        "--out-dir",
+        default="src",
+        help="Directory for font_pack.c and font_pack.h (default: src)",
+    )
+    parser.add_argument(
+        "--depfile",
+        help="Write a Makefile-style dependency file for the build system",
+    )
+    return parser.parse_args()
+
+
+def unescape_c(literal: str) -> str:
+    def repl(match: re.Match) -> str:
+        esc = match.group(1)
+        if esc[0] == "x":
+            return chr(int(esc[1:], 16))
+        if esc[0] in "01234567":
+            return chr(int(esc, 8))
+        return SIMPLE_ESCAPES.get(esc, esc)
+
+    # Literals are UTF-8 in the source; escapes produce raw bytes like C does
+    raw = C_ESCAPE.sub(repl, literal)
+    try:
+        return raw.encode("latin-1").decode("utf-8")
+    except (UnicodeEncodeError, UnicodeDecodeError):
+        return raw
+
+
+def strings_in_c(text: str) -> list:
+    strings = []
+    for match in C_TOKEN.finditer(text):
+        if match.group(1) is not None:
+            strings.append(PRINTF_CONVERSION.sub("", unescape_c(match.group(1))))
+    return strings
+
+
+def strings_in_json(value) -> list:
+    if isinstance(value, str):
+        return [value]
+    if isinstance(value, dict):
+        value = list(value.values())
+    if isinstance(value, list):
+        return [s for item in value for s in strings_in_json(item)]
+    return []
+
+
+def strings_in_file(path: str) -> list:
+    with open(path, encoding="utf-8") as f:
+        text = f.read()
+    if path.endswith(C_EXTENSIONS):
+        return strings_in_c(text)
+    if path.endswith(".json"):
+        return strings_in_json(json.loads(text))
+    return text.splitlines()
+
+
+def glyph_set(entry: dict, base: str, deps: set) -> list:
+    chars = set(entry.get("chars", ""))
+    for source in entry.get("sources", []):
+        path = os.path.normpath(os.path.join(base, source))
+        deps.add(path)
+        for s in strings_in_file(path):
+            chars.update(s)
+    # Control characters never have a glyph
+    return sorted(c for c in chars if c.isprintable() and ord(c) <= 0xFFFF)
+
+
+def render_font(font_path: str, size: int, chars: list) -> tuple:
+    """Render chars into one fixed cell each, returning (width, height, bitmaps)."""
+    font = ImageFont.truetype(font_path, size)
+
+    bboxes = [font.getbbox(ch) for ch in chars]
+    min_top = min(b[1] for b in bboxes)
+    max_bottom = max(b[3] for b in bboxes)
+    max_width = max(max(b[2] - b[0], 1) for b in bboxes)
+
+    height = int(math.ceil((max_bottom - min_top) / 8.0) * 8)
+    width = max_width
+    if width > 255 or height > 255:
+        raise SystemExit(f"{font_path} at {size}pt needs a {width}x{height} cell, max is 255")
+
+    bitmaps = []
+    for ch, (left, top, right, bottom) in zip(chars, bboxes):
+        img = Image.new("1", (width, height), 1)
+        draw = ImageDraw.Draw(img)
+        glyph_w = right - left
+        draw.text(((width - glyph_w) // 2 - left, -min_top), ch, font=font, fill=0)
+
+        # Vertically packed: column by column, one byte per 8 rows, MSB on top
+        px = img.load()
+        data = bytearray()
+        for x in range(width):
+            for page in range(height // 8):
+                byte = 0
+                for bit in range(8):
+                    if px[x, page * 8 + bit] == 0:
+                        byte |= 0x80 >> bit
+                data.append(byte)
+        bitmaps.append(bytes(data))
+
+    return width, height, bitmaps
+
+
+def c_array(values: list, fmt: str, per_line: int) -> str:
+    lines = []
+    for i in range(0, len(values), per_line):
+        lines.append("\t" + ", ".join(fmt.format(v) for v in values[i:i + per_line]) + ",")
+    return "\n".join(lines)
+
+
+def main() -> None:
+    args = parse_args()
+    manifest_path = args.manifest
+    base = os.path.dirname(os.path.abspath(manifest_path))
+
+    with open(manifest_path, encoding="utf-8") as f:
+        manifest = json.load(f)
+
+    deps = {os.path.abspath(manifest_path)}
+    pool = bytearray()
+    pool_index = {}
+    fonts = []
+    total_glyphs = 0
+
+    for entry in manifest["fonts"]:
+        font_path = os.path.normpath(os.path.join(base, entry["font"]))
+        deps.add(font_path)
+        chars = glyph_set(entry, base, deps)
+        if not chars:
+            raise SystemExit(f"No characters needed for font '{entry['name']}'")
+
+        for size in entry["sizes"]:
+            width, height, bitmaps = render_font(font_path, size, chars)
+            offsets = []
+            for data in bitmaps:
+                if data not in pool_index:
+                    pool_index[data] = len(pool)
+                    pool.extend(data)
+                offsets.append(pool_index[data])
+            total_glyphs += len(bitmaps)
+            fonts.append({
+                "ident": f"font_pack_{entry['name']}_{size}",
+                "chars": chars,
+                "width": width,
+                "height": height,
+                "offsets": offsets,
+            })
+
+    os.makedirs(args.out_dir, exist_ok=True)
+    out_c = os.path.join(args.out_dir, "font_pack.c")
+    out_h = os.path.join(args.out_dir, "font_pack.h")
+    header = (
+        "/*\n"
+        " * This file was automatically generated using the following command:\n"
+        f" * tools/gen_font_pack.py --manifest {manifest_path}\n"
+        " *\n"
+        f" * {len(fonts)} fonts, {total_glyphs} glyphs, {len(pool_index)} unique bitmaps "
+        f"({len(pool)} bytes)\n"
+        " */\n"
+    )
+
+    with open(out_h, "w", encoding="utf-8") as f:
+        f.write(header)
+        f.write("\n#ifndef FONT_PACK_H\n#define FONT_PACK_H\n\n")
+        f.write('#include "display_lib.h"\n\n')
+        for font in fonts:
+            f.write(f"extern const struct display_font {font['ident']};\n")
+        f.write("\n#endif /* FONT_PACK_H */\n")
+
+    with open(out_c, "w", encoding="utf-8") as f:
+        f.write(header)
+        f.write('\n#include <zephyr/kernel.h>\n#include "font_pack.h"\n\n')
+        f.write(f"static const uint8_t font_pack_bitmaps[{len(pool)}] = {{\n")
+        f.write(c_array(list(pool), "0x{:02x}", 16))
+        f.write("\n};\n")
+        for font in fonts:
+            ident = font["ident"]
+            f.write(f"\n/* {''.join(font['chars']).replace('*/', '* /')} */\n")
+            f.write(f"static const uint16_t {ident}_chars[] = {{\n")
+            f.write(c_array([ord(c) for c in font["chars"]], "0x{:04x}", 12))
+            f.write(f"\n}};\n\nstatic const uint32_t {ident}_offsets[] = {{\n")
+            f.write(c_array(font["offsets"], "{}", 12))
+            f.write("\n};\n\n")
+            f.write(f"const struct display_font {ident} = {{\n")
+            f.write(f"\t.width = {font['width']},\n")
+            f.write(f"\t.height = {font['height']},\n")
+            f.write(f"\t.num_glyphs = {len(font['chars'])},\n")
+            f.write(f"\t.chars = {ident}_chars,\n")
+            f.write(f"\t.offsets = {ident}_offsets,\n")
+            f.write("\t.bitmaps = font_pack_bitmaps,\n};\n")
+
+    if args.depfile:
+        with open(args.depfile, "w", encoding="utf-8") as f:
+            paths = " ".join(p.replace(" ", "\\ ") for p in sorted(deps))
+            f.write(f"{os.path.abspath(out_c)} {os.path.abspath(out_h)}: {paths}\n")
+
+    print(f"Generated: {out_c} ({total_glyphs} glyphs, {len(pool)} bitmap bytes)")
+
+
+if __name__ == "__main__":
+    main()
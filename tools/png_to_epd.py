@@ -0,0 +1,225 @@
+#!/usr/bin/env python3
+"""
+Convert PNGs into panel-native RAM images for epd_display_image().
+
+Usage:
+  python3 tools/png_to_epd.py splash.png error.png --out-dir src
+example (splash in the top-left corner, dithered):
+  python3 tools/png_to_epd.py splash.png --pos 0,0 --dither --out-dir src
+
+Images are drawn in the logical landscape orientation used by CFB
+(248x128 on the 2.13" V4). Each one is placed at --pos, rotated into the
+panel's portrait RAM layout and inverted to its polarity (1 = white), so
+the firmware streams it into RAM without touching a single bit. Panels
+that are natively landscape (profiles with EPD_ROTATE_90 0, such as the
+4.2" V2 with --panel 400x300) take --no-rotate.
+
+Only the RAM window covering the image is stored. RAM X addresses whole
+bytes, i.e. groups of 8 logical rows (8 logical columns with
+--no-rotate), so the image's edges along that axis must fall on a
+multiple of 8: padding would overwrite whatever the panel shows next to
+the image. Pass --pad to accept that and pad with --background, or --full
+to store the whole panel instead (pixels outside the image use
+--background), which also overwrites the rows CFB never draws.
+
+Requirements:
+  - PIL/Pillow (python3 -m pip install pillow)
+
+Outputs:
+  - <out-dir>/epd_images.c
+  - <out-dir>/epd_images.h
+"""
+
+import argparse
+import os
+import re
+
+from PIL import Image
+
+
+def parse_pair(text: str, sep: str) -> tuple:
+    try:
+        a, b = text.split(sep)
+        return int(a), int(b)
+    except ValueError:
+        raise argparse.ArgumentTypeError(f"expected A{sep}B, got '{text}'")
+
+
+def parse_args() -> argparse.Namespace:
+    parser = argparse.ArgumentParser(
+        description="Convert PNGs into pre-rotated, pre-inverted e-paper RAM images."
+    )
+    parser.add_argument("images", nargs="+", help="PNG files; the file stem names the image")
+    parser.add_argument(
+        "--out-dir",
+        default="src",
+        help="Directory for epd_images.c and epd_images.h (default: src)",
+    )
+    parser.add_argument(
+        "--pos",
+        type=lambda s: parse_pair(s, ","),
+        default=(0, 0),
+        help="Logical X,Y of the image's top-left corner (default: 0,0)",
+    )
+    parser.add_argument(
+        "--panel",
+        type=lambda s: parse_pair(s, "x"),
+        default=(128, 250),
+        help="Panel RAM size as WIDTHxHEIGHT in native pixels (default: 128x250)",
+    )
+    parser.add_argument(
+        "--no-rotate",
+        action="store_true",
+        help="Panel is natively landscape; keep the image orientation",
+    )
+    parser.add_argument(
+        "--threshold",
+        type=int,
+        default=128,
+        help="Gray level below which a pixel is black (default: 128)",
+    )
+    parser.add_argument(
+        "--dither",
+        action="store_true",
+        help="Floyd-Steinberg dither instead of thresholding",
+    )
+    parser.add_argument(
+        "--background",
+        choices=("white", "black"),
+        default="white",
+        help="Colour of padding around the image (default: white)",
+    )
+    parser.add_argument(
+        "--full",
+        action="store_true",
+        help="Store the whole panel rather than the window around the image",
+    )
+    parser.add_argument(
+        "--pad",
+        action="store_true",
+        help="Pad edges that are not byte-aligned in RAM with --background",
+    )
+    return parser.parse_args()
+
+
+def to_mono(path: str, args: argparse.Namespace) -> Image.Image:
+    """Load an image as 1-bit, 255 = white."""
+    img = Image.open(path)
+    if img.mode in ("RGBA", "LA", "P"):
+        # Transparent areas take the background colour
+        img = img.convert("RGBA")
+        bg = Image.new("RGBA", img.size, (255,) * 4 if args.background == "white" else (0, 0, 0, 255))
+        img = Image.alpha_composite(bg, img)
+    gray = img.convert("L")
+    if args.dither:
+        return gray.convert("1")
+    return gray.point(lambda v: 255 if v >= args.threshold else 0, mode="1")
+
+
+def ram_image(mono: Image.Image, args: argparse.Namespace) -> tuple:
+    """Return (xs, xe, ys, ye, data) for the RAM window holding the image."""
+    panel_w, panel_h = args.panel
+    lx0, ly0 = args.pos
+    lx1, ly1 = lx0 + mono.width - 1, ly0 + mono.height - 1
+
+    if args.no_rotate:
+        def logical(px_x, px_y):
+            return px_x, px_y
+        px0, px1, py0, py1 = lx0, lx1, ly0, ly1
+    else:
+        # Logical X runs up the panel from its last row, logical Y across it
+        def logical(px_x, px_y):
+            return panel_h - 1 - px_y, px_x
+        px0, px1, py0, py1 = ly0, ly1, panel_h - 1 - lx1, panel_h - 1 - lx0
+
+    if px0 < 0 or py0 < 0 or px1 >= panel_w or py1 >= panel_h:
+        raise SystemExit(f"Image at {args.pos} ({mono.width}x{mono.height}) does not fit the panel")
+
+    if args.full:
+        xs, xe, ys, ye = 0, panel_w // 8 - 1, 0, panel_h - 1
+    else:
+        if (px0 % 8 != 0 or (px1 + 1) % 8 != 0) and not args.pad:
+            axis = "X and width" if args.no_rotate else "Y and height"
+            raise SystemExit(
+                f"Image at {args.pos} ({mono.width}x{mono.height}): logical {axis} must be "
+                "multiples of 8, or padding overwrites the pixels beside it; "
+                "pass --pad or --full to pad with --background"
+            )
+        xs, xe, ys, ye = px0 // 8, px1 // 8, py0, py1
+
+    fill = 0xFF if args.background == "white" else 0x00
+    px = mono.load()
+    data = bytearray()
+    for row in range(ys, ye + 1):
+        for xb in range(xs, xe + 1):
+            byte = fill
+            for bit in range(8):
+                lx, ly = logical(xb * 8 + bit, row)
+                if lx0 <= lx <= lx1 and ly0 <= ly <= ly1:
+                    mask = 0x80 >> bit
+                    if px[lx - lx0, ly - ly0]:
+                        byte |= mask
+                    else:
+                        byte &= ~mask
+            data.append(byte)
+
+    return xs, xe, ys, ye, bytes(data)
+
+
+def c_ident(path: str) -> str:
+    stem = os.path.splitext(os.path.basename(path))[0]
+    ident = re.sub(r"\W", "_", stem).lower()
+    return "_" + ident if ident[0].isdigit() else ident
+
+
+def main() -> None:
+    args = parse_args()
+
+    images = []
+    for path in args.images:
+        xs, xe, ys, ye, data = ram_image(to_mono(path, args), args)
+        images.append({"ident": f"epd_image_{c_ident(path)}", "path": path,
+                       "window": (xs, xe, ys, ye), "data": data})
+
+    os.makedirs(args.out_dir, exist_ok=True)
+    out_c = os.path.join(args.out_dir, "epd_images.c")
+    out_h = os.path.join(args.out_dir, "epd_images.h")
+    header = (
+        "/*\n"
+        " * This file was automatically generated using the following command:\n"
+        f" * tools/png_to_epd.py {' '.join(os.path.basename(p) for p in args.images)}\n"
+        " */\n"
+    )
+
+    with open(out_h, "w", encoding="utf-8") as f:
+        f.write(header)
+        f.write("\n#ifndef EPD_IMAGES_H\n#define EPD_IMAGES_H\n\n")
+        f.write('#include "epd_driver.h"\n\n')
+        for image in images:
+            f.write(f"extern const struct epd_image {image['ident']};\n")
+        f.write("\n#endif /* EPD_IMAGES_H */\n")
+
+    with open(out_c, "w", encoding="utf-8") as f:
+        f.write(header)
+        f.write('\n#include <zephyr/kernel.h>\n#include "epd_images.h"\n')
+        for image in images:
+            ident = image["ident"]
+            xs, xe, ys, ye = image["window"]
+            data = image["data"]
+            f.write(f"\n/* {os.path.basename(image['path'])}: RAM X bytes {xs}-{xe}, "
+                    f"rows {ys}-{ye} */\n")
+            f.write(f"static const uint8_t {ident}_data[{len(data)}] = {{\n")
+            per_line = xe - xs + 1 if xe - xs + 1 <= 16 else 16
+            for i in range(0, len(data), per_line):
+                f.write("\t" + ", ".join(f"0x{b:02x}" for b in data[i:i + per_line]) + ",\n")
+            f.write("};\n\n")
+            f.write(f"const struct epd_image {ident} = {{\n")
+            f.write(f"\t.data = {ident}_data,\n")
+            f.write(f"\t.xs = {xs},\n\t.xe = {xe},\n\t.ys = {ys},\n\t.ye = {ye},\n}};\n")
+
+    total = sum(len(image["data"]) for image in images)
+    print(f"Generated: {out_c} ({len(images)} images, {total} bytes)")
+
+
+if __name__ == "__main__":
+    main()